@@ -0,0 +1,142 @@
+#version 330 core
+in vec3 vertexColor;
+in vec3 worldPosition;
+in vec3 worldNormal;
+in float viewDepth;
+in vec2 textureCoord;
+flat in int textureLayer;
+out vec4 FragColor;
+
+// Cluster grid size; must match src/lighting/cluster_grid.h
+const int CLUSTERS_X = 16;
+const int CLUSTERS_Y = 9;
+const int CLUSTERS_Z = 24;
+const int CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+// Shadow cascades per view; must match src/renderer/renderer.c
+const int SHADOW_CASCADES = 4;
+
+// Per-view camera, bound from the streaming buffer
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewport;          // x, y, 1 / width, 1 / height in pixels
+    vec4 clusterSlices;     // Depth slice = log(depth) * x + y
+    mat4 shadowMatrices[4]; // World to shadow map coordinates of each cascade
+    vec4 shadowSplits;      // Farthest view depth each cascade covers
+    vec4 shadowTexels;      // World-space size of a shadow map texel in each cascade
+    vec4 shadowParams;      // x: layer of the first cascade, negative without shadows
+};
+
+// Point lights share the RGBA32F view of the streaming buffer with the model
+// matrices: position and radius, then color, for each light from lightBase
+uniform samplerBuffer models;
+uniform int lightBase;
+
+// Per-view light lists: (first, count) for every cluster, then light indices
+uniform usamplerBuffer clusters;
+uniform int clusterBase;
+
+// Label textures, streamed page by page into a cache: each page's slot + 1
+// (0 if not resident) is in the page table, and every page is pageSize
+// texels wide including pageBorder texels on each side
+uniform bool virtualTexturing;
+uniform sampler2DArray pageCache;
+uniform usamplerBuffer pageTable;
+uniform int virtualPages; // Pages per side of level 0
+uniform int virtualLevels;
+uniform int pageSize;
+uniform int pageBorder;
+
+// Shadow maps of the key light; each view's cascades are consecutive layers
+uniform sampler2DArrayShadow shadowMap;
+
+// Light that every surface gets regardless of the point lights
+// The key light's direction must match src/renderer/renderer.c.
+const vec3 ambientLight = vec3(0.25);
+const vec3 keyLightDirection = vec3(0.3, 0.9, 0.3);
+const vec3 keyLightColor = vec3(0.45);
+
+// First page of a level within its layer's part of the page table
+int levelOffset(int level)
+{
+   return ((1 << (2 * virtualLevels)) - (1 << (2 * (virtualLevels - level)))) / 3;
+}
+
+// Sample a label at the level its footprint asks for, or the nearest
+// coarser level that is resident
+vec3 sampleVirtual(vec2 uv, int layer)
+{
+   int content = pageSize - 2 * pageBorder;
+   vec2 texels = uv * float(virtualPages * content);
+   float lod = log2(max(length(dFdx(texels)), length(dFdy(texels))));
+   uv = clamp(uv, 0.0, 1.0);
+
+   int layerBase = layer * levelOffset(virtualLevels);
+   for (int level = clamp(int(floor(lod)), 0, virtualLevels - 1); level < virtualLevels; level++) {
+      int pages = virtualPages >> level;
+      ivec2 page = min(ivec2(uv * float(pages)), ivec2(pages - 1));
+      uint slot = texelFetch(pageTable, layerBase + levelOffset(level) + page.y * pages + page.x).r;
+      if (slot != 0u) {
+         vec2 inPage = uv * float(pages) - vec2(page);
+         vec2 cacheCoord = (inPage * float(content) + float(pageBorder)) / float(pageSize);
+         return textureLod(pageCache, vec3(cacheCoord, float(slot - 1u)), 0.0).rgb;
+      }
+   }
+   return vec3(1.0);
+}
+
+// Fraction of the key light reaching this fragment, from the first cascade
+// that covers its depth
+float keyLightVisibility(vec3 normal)
+{
+   if (shadowParams.x < 0.0 || viewDepth > shadowSplits[SHADOW_CASCADES - 1]) {
+      return 1.0;
+   }
+   int cascade = 0;
+   while (viewDepth > shadowSplits[cascade]) {
+      cascade++;
+   }
+
+   // Look up a little off the surface so it does not shadow itself, further
+   // where the light grazes it
+   float grazing = 1.0 - max(dot(normal, normalize(keyLightDirection)), 0.0);
+   vec3 position = worldPosition + normal * (shadowTexels[cascade] * (1.0 + 3.0 * grazing));
+   vec4 coord = shadowMatrices[cascade] * vec4(position, 1.0);
+   return texture(shadowMap, vec4(coord.xy, shadowParams.x + float(cascade), coord.z));
+}
+
+void main()
+{
+   vec3 albedo = vertexColor;
+   if (virtualTexturing) {
+      albedo *= sampleVirtual(textureCoord, textureLayer);
+   }
+
+   vec3 normal = normalize(worldNormal);
+   float keyLight = max(dot(normal, normalize(keyLightDirection)), 0.0) * keyLightVisibility(normal);
+   vec3 lighting = ambientLight + keyLightColor * keyLight;
+
+   // Find this fragment's cluster
+   ivec2 tile = ivec2((gl_FragCoord.xy - viewport.xy) * viewport.zw * vec2(CLUSTERS_X, CLUSTERS_Y));
+   tile = clamp(tile, ivec2(0), ivec2(CLUSTERS_X - 1, CLUSTERS_Y - 1));
+   int slice = clamp(int(floor(log(viewDepth) * clusterSlices.x + clusterSlices.y)), 0, CLUSTERS_Z - 1);
+   int cluster = (slice * CLUSTERS_Y + tile.y) * CLUSTERS_X + tile.x;
+
+   // Only the lights that can reach this cluster
+   int first = int(texelFetch(clusters, clusterBase + cluster * 2).r);
+   int count = int(texelFetch(clusters, clusterBase + cluster * 2 + 1).r);
+   int indexBase = clusterBase + CLUSTER_COUNT * 2 + first;
+   for (int i = 0; i < count; i++) {
+      int light = lightBase + int(texelFetch(clusters, indexBase + i).r) * 2;
+      vec4 positionRadius = texelFetch(models, light);
+      vec3 color = texelFetch(models, light + 1).rgb;
+
+      vec3 toLight = positionRadius.xyz - worldPosition;
+      float distance = length(toLight);
+      float falloff = clamp(1.0 - distance / positionRadius.w, 0.0, 1.0);
+      lighting += color * (falloff * falloff) * max(dot(normal, toLight / max(distance, 1e-4)), 0.0);
+   }
+
+   FragColor = vec4(albedo * lighting, 1.0);
+}
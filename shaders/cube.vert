@@ -0,0 +1,57 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in uint aInstance; // Index into the shared model matrices
+layout (location = 3) in vec3 aNormal;
+layout (location = 4) in vec3 aTexCoord; // u, v and face number
+out vec3 vertexColor;
+out vec3 worldPosition;
+out vec3 worldNormal;
+out float viewDepth; // Distance in front of the camera, for the cluster lookup
+out vec2 textureCoord;
+flat out int textureLayer;
+
+// Per-view camera, bound from the streaming buffer
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewport;          // x, y, 1 / width, 1 / height in pixels
+    vec4 clusterSlices;     // Depth slice = log(depth) * x + y
+    mat4 shadowMatrices[4]; // World to shadow map coordinates of each cascade
+    vec4 shadowSplits;      // Farthest view depth each cascade covers
+    vec4 shadowTexels;      // World-space size of a shadow map texel in each cascade
+    vec4 shadowParams;      // x: layer of the first cascade, negative without shadows
+};
+
+// Model matrices of the whole scene, uploaded once per frame for all views
+// Each matrix is four consecutive RGBA32F texels starting at modelBase
+uniform samplerBuffer models;
+uniform int modelBase;
+
+// Number of label textures in the virtual texture, 0 without one
+uniform int virtualLayers;
+
+mat4 fetchModel(uint instance)
+{
+   int texel = modelBase + int(instance) * 4;
+   return mat4(texelFetch(models, texel),
+               texelFetch(models, texel + 1),
+               texelFetch(models, texel + 2),
+               texelFetch(models, texel + 3));
+}
+
+void main()
+{
+   mat4 model = fetchModel(aInstance);
+   vec4 world = model * vec4(aPos, 1.0);
+   vec4 eye = view * world;
+   gl_Position = projection * eye;
+   vertexColor = aColor;
+   worldPosition = world.xyz;
+   // Scales in the scene are uniform, so the model matrix transforms normals too
+   worldNormal = mat3(model) * aNormal;
+   viewDepth = -eye.z;
+   // Every face of every cube gets its own label
+   textureCoord = aTexCoord.xy;
+   textureLayer = virtualLayers > 0 ? int((aInstance * 6u + uint(aTexCoord.z)) % uint(virtualLayers)) : 0;
+}
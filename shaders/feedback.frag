@@ -0,0 +1,31 @@
+#version 330 core
+in vec2 textureCoord;
+flat in int textureLayer;
+out uint pageNumber;
+
+// Layout of the virtual texture; see cube.frag
+uniform int virtualPages;
+uniform int virtualLevels;
+uniform int pageSize;
+uniform int pageBorder;
+
+// log2 of how much smaller the feedback target is than the views
+uniform float feedbackScale;
+
+int levelOffset(int level)
+{
+   return ((1 << (2 * virtualLevels)) - (1 << (2 * (virtualLevels - level)))) / 3;
+}
+
+// Write the number + 1 of the page cube.frag would like to sample here
+void main()
+{
+   vec2 texels = textureCoord * float(virtualPages * (pageSize - 2 * pageBorder));
+   float lod = log2(max(length(dFdx(texels)), length(dFdy(texels)))) - feedbackScale;
+   int level = clamp(int(floor(lod)), 0, virtualLevels - 1);
+
+   int pages = virtualPages >> level;
+   ivec2 page = min(ivec2(clamp(textureCoord, 0.0, 1.0) * float(pages)), ivec2(pages - 1));
+   int layerBase = textureLayer * levelOffset(virtualLevels);
+   pageNumber = uint(layerBase + levelOffset(level) + page.y * pages + page.x + 1);
+}
@@ -0,0 +1,6 @@
+#version 330 core
+
+// Depth only; there is no color attachment to write to
+void main()
+{
+}
@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in uint aInstance; // Index into the shared model matrices
+
+// Light view and projection of one shadow cascade; the same layout as the
+// start of the Camera block in cube.vert
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+
+// Model matrices of the whole scene, as in cube.vert
+uniform samplerBuffer models;
+uniform int modelBase;
+
+mat4 fetchModel(uint instance)
+{
+   int texel = modelBase + int(instance) * 4;
+   return mat4(texelFetch(models, texel),
+               texelFetch(models, texel + 1),
+               texelFetch(models, texel + 2),
+               texelFetch(models, texel + 3));
+}
+
+// Position only: shadow maps need nothing but depth
+void main()
+{
+   gl_Position = projection * view * (fetchModel(aInstance) * vec4(aPos, 1.0));
+}
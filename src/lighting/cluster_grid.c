@@ -0,0 +1,235 @@
+#include "cluster_grid.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+
+// A light in view space, with d the distance in front of the camera, and
+// the depth slices its sphere reaches; z0 > z1 when it is outside the view
+typedef struct {
+    float x, y, d, r;
+    int z0, z1;
+} LightRange;
+
+// Define the actual cluster grid implementation structure
+struct ClusterGridImpl {
+    int max_lights;
+    LightRange* ranges;
+    
+    // Light count and first index of every cluster; the fill pass reuses
+    // counts as cursors and restores them
+    unsigned int counts[CLUSTER_GRID_COUNT];
+    unsigned int offsets[CLUSTER_GRID_COUNT];
+    int total;
+    
+    // Inputs of the current assignment, read by the tasks
+    const float* view;
+    const float* projection;
+    const float* lights;
+    int light_count;
+    float near_plane;
+    float far_plane;
+    float slice_scale;
+    float slice_bias;
+    float slice_near[CLUSTER_GRID_Z + 1];
+    unsigned int* output;
+};
+
+// Depth slice containing view-space distance d
+static int slice_of(ClusterGrid grid, float d) {
+    int slice = (int)floorf(logf(d) * grid->slice_scale + grid->slice_bias);
+    if (slice < 0) return 0;
+    if (slice > CLUSTER_GRID_Z - 1) return CLUSTER_GRID_Z - 1;
+    return slice;
+}
+
+// Tile containing normalized device coordinate ndc along an axis of size count
+static int tile_of(float ndc, int count) {
+    int tile = (int)floorf((ndc * 0.5f + 0.5f) * (float)count);
+    if (tile < 0) return 0;
+    if (tile > count - 1) return count - 1;
+    return tile;
+}
+
+// Transform each light to view space and find its depth slices
+static void compute_ranges(void* context, int begin, int end) {
+    ClusterGrid grid = (ClusterGrid)context;
+    const float* v = grid->view;
+    
+    for (int i = begin; i < end; i++) {
+        const float* light = grid->lights + (size_t)i * 4;
+        LightRange* range = &grid->ranges[i];
+        range->x = v[0] * light[0] + v[4] * light[1] + v[8] * light[2] + v[12];
+        range->y = v[1] * light[0] + v[5] * light[1] + v[9] * light[2] + v[13];
+        range->d = -(v[2] * light[0] + v[6] * light[1] + v[10] * light[2] + v[14]);
+        range->r = light[3];
+        range->z0 = 1;
+        range->z1 = 0;
+        
+        float d_min = fmaxf(range->d - range->r, grid->near_plane);
+        float d_max = fminf(range->d + range->r, grid->far_plane);
+        if (d_min > d_max) continue;
+        
+        range->z0 = slice_of(grid, d_min);
+        range->z1 = slice_of(grid, d_max);
+    }
+}
+
+// Find the tiles touched by the part of a light's sphere inside depth slice z
+// Returns false if that part is outside the viewport.
+static bool slice_tiles(ClusterGrid grid, const LightRange* range, int z, int* x0, int* x1, int* y0, int* y1) {
+    float d_min = fmaxf(fmaxf(grid->slice_near[z], range->d - range->r), grid->near_plane);
+    float d_max = fminf(fminf(grid->slice_near[z + 1], range->d + range->r), grid->far_plane);
+    if (d_min > d_max) return false;
+    
+    // The sphere's cross-section is widest at the depth closest to its center
+    float offset = range->d < d_min ? d_min - range->d : (range->d > d_max ? range->d - d_max : 0.0f);
+    float r = sqrtf(fmaxf(range->r * range->r - offset * offset, 0.0f));
+    
+    // x / d over the bounding box of that part is extreme at its corners
+    float scale_x = grid->projection[0];
+    float scale_y = grid->projection[5];
+    float x_min = fminf((range->x - r) / d_min, (range->x - r) / d_max) * scale_x;
+    float x_max = fmaxf((range->x + r) / d_min, (range->x + r) / d_max) * scale_x;
+    float y_min = fminf((range->y - r) / d_min, (range->y - r) / d_max) * scale_y;
+    float y_max = fmaxf((range->y + r) / d_min, (range->y + r) / d_max) * scale_y;
+    if (x_max < -1.0f || x_min > 1.0f || y_max < -1.0f || y_min > 1.0f) return false;
+    
+    *x0 = tile_of(x_min, CLUSTER_GRID_X);
+    *x1 = tile_of(x_max, CLUSTER_GRID_X);
+    *y0 = tile_of(y_min, CLUSTER_GRID_Y);
+    *y1 = tile_of(y_max, CLUSTER_GRID_Y);
+    return true;
+}
+
+// Count the lights of every cluster in depth slices [begin, end)
+// Each task owns whole slices, so no two tasks touch the same cluster
+static void count_slices(void* context, int begin, int end) {
+    ClusterGrid grid = (ClusterGrid)context;
+    
+    for (int c = begin * CLUSTER_GRID_X * CLUSTER_GRID_Y; c < end * CLUSTER_GRID_X * CLUSTER_GRID_Y; c++) {
+        grid->counts[c] = 0;
+    }
+    
+    for (int i = 0; i < grid->light_count; i++) {
+        const LightRange* range = &grid->ranges[i];
+        int z0 = range->z0 > begin ? range->z0 : begin;
+        int z1 = range->z1 < end - 1 ? range->z1 : end - 1;
+        for (int z = z0; z <= z1; z++) {
+            int x0, x1, y0, y1;
+            if (!slice_tiles(grid, range, z, &x0, &x1, &y0, &y1)) continue;
+            
+            for (int y = y0; y <= y1; y++) {
+                unsigned int* row = grid->counts + (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X;
+                for (int x = x0; x <= x1; x++) {
+                    row[x]++;
+                }
+            }
+        }
+    }
+}
+
+// Write the table entries and light indices of depth slices [begin, end)
+static void fill_slices(void* context, int begin, int end) {
+    ClusterGrid grid = (ClusterGrid)context;
+    unsigned int* table = grid->output;
+    unsigned int* indices = grid->output + CLUSTER_GRID_COUNT * 2;
+    int first = begin * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+    int last = end * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+    
+    for (int c = first; c < last; c++) {
+        table[c * 2] = grid->offsets[c];
+        table[c * 2 + 1] = grid->counts[c];
+        grid->counts[c] = 0;
+    }
+    
+    // Lights go in ascending order, so the result does not depend on threading
+    for (int i = 0; i < grid->light_count; i++) {
+        const LightRange* range = &grid->ranges[i];
+        int z0 = range->z0 > begin ? range->z0 : begin;
+        int z1 = range->z1 < end - 1 ? range->z1 : end - 1;
+        for (int z = z0; z <= z1; z++) {
+            int x0, x1, y0, y1;
+            if (!slice_tiles(grid, range, z, &x0, &x1, &y0, &y1)) continue;
+            
+            for (int y = y0; y <= y1; y++) {
+                int row = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X;
+                for (int x = x0; x <= x1; x++) {
+                    int c = row + x;
+                    indices[grid->offsets[c] + grid->counts[c]++] = (unsigned int)i;
+                }
+            }
+        }
+    }
+}
+
+ClusterGrid cluster_grid_create(int max_lights) {
+    ClusterGrid grid = (ClusterGrid)calloc(1, sizeof(struct ClusterGridImpl));
+    if (!grid) {
+        fprintf(stderr, "Failed to allocate cluster grid\n");
+        return NULL;
+    }
+    
+    grid->max_lights = max_lights > 0 ? max_lights : 0;
+    if (grid->max_lights > 0) {
+        grid->ranges = (LightRange*)malloc((size_t)grid->max_lights * sizeof(LightRange));
+        if (!grid->ranges) {
+            fprintf(stderr, "Failed to allocate cluster grid\n");
+            free(grid);
+            return NULL;
+        }
+    }
+    
+    return grid;
+}
+
+int cluster_grid_assign(ClusterGrid grid, ThreadPool pool, const float* view, const float* projection,
+                        float near_plane, float far_plane, const float* lights, int light_count) {
+    if (!grid) return 0;
+    
+    grid->view = view;
+    grid->projection = projection;
+    grid->lights = lights;
+    grid->light_count = light_count < grid->max_lights ? light_count : grid->max_lights;
+    grid->near_plane = near_plane;
+    grid->far_plane = far_plane;
+    grid->slice_scale = (float)CLUSTER_GRID_Z / logf(far_plane / near_plane);
+    grid->slice_bias = -logf(near_plane) * grid->slice_scale;
+    for (int z = 0; z <= CLUSTER_GRID_Z; z++) {
+        grid->slice_near[z] = near_plane * powf(far_plane / near_plane, (float)z / CLUSTER_GRID_Z);
+    }
+    
+    thread_pool_parallel_for(pool, grid->light_count, 256, compute_ranges, grid);
+    thread_pool_parallel_for(pool, CLUSTER_GRID_Z, 1, count_slices, grid);
+    
+    // Lists are stored back to back in cluster order
+    unsigned int total = 0;
+    for (int c = 0; c < CLUSTER_GRID_COUNT; c++) {
+        grid->offsets[c] = total;
+        total += grid->counts[c];
+    }
+    grid->total = (int)total;
+    return grid->total;
+}
+
+void cluster_grid_write(ClusterGrid grid, ThreadPool pool, unsigned int* data) {
+    if (!grid || !data) return;
+    
+    grid->output = data;
+    thread_pool_parallel_for(pool, CLUSTER_GRID_Z, 1, fill_slices, grid);
+    grid->output = NULL;
+}
+
+void cluster_grid_get_slice_params(ClusterGrid grid, float* scale, float* bias) {
+    if (!grid) return;
+    
+    *scale = grid->slice_scale;
+    *bias = grid->slice_bias;
+}
+
+void cluster_grid_destroy(ClusterGrid grid) {
+    if (!grid) return;
+    
+    free(grid->ranges);
+    free(grid);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef CLUSTER_GRID_H
+#define CLUSTER_GRID_H
+
+#include "../utils/thread/thread_pool.h"
+
+// Clusters per axis of the view frustum; shaders/cube.frag uses the same values
+// Tiles split the viewport evenly, depth slices are spaced exponentially.
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_GRID_COUNT (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+
+// Opaque handle for the light lists of one view's clusters
+typedef struct ClusterGridImpl* ClusterGrid;
+
+// Create a cluster grid for up to max_lights lights
+ClusterGrid cluster_grid_create(int max_lights);
+
+// Find the lights touching each cluster of a view
+// lights holds x, y, z and radius of every light in world space. The
+// projection must be a symmetric perspective with the given near and far
+// planes. Work is spread over the pool (which may be NULL).
+// Returns the number of light indices referenced by the clusters.
+int cluster_grid_assign(ClusterGrid grid, ThreadPool pool, const float* view, const float* projection,
+                        float near_plane, float far_plane, const float* lights, int light_count);
+
+// Write the result of the last assignment, laid out as the shader reads it:
+// CLUSTER_GRID_COUNT pairs of (first index, light count), then the indices
+// Cluster (x, y, z) is entry (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x.
+void cluster_grid_write(ClusterGrid grid, ThreadPool pool, unsigned int* data);
+
+// Depth slice of a view-space distance d is floor(log(d) * scale + bias)
+void cluster_grid_get_slice_params(ClusterGrid grid, float* scale, float* bias);
+
+// Destroy the cluster grid
+void cluster_grid_destroy(ClusterGrid grid);
+
+#endif /* CLUSTER_GRID_H */
\ No newline at end of file
@@ -1,25 +1,166 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "renderer/renderer.h"
+#include "utils/texture/label_tiles.h"
+#include "utils/thread/thread_pool.h"
 
-int main() {
+int main(int argc, char** argv) {
     printf("Hello from Cube!\n");
     
+    // Parse command line options
+    bool second_window = false;
+    bool overview_view = false;
+    bool hash_frames = false;
+    bool occlusion_culling = true;
+    bool shadows = true;
+    bool cache_shadows = true;
+    int grid_size = 0;
+    int light_count = -1;
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    const char* timings_path = NULL;
+    const char* texture_path = NULL;
+    const char* make_textures_path = NULL;
+    int texture_budget_mb = 0;
+    int metrics_port = 0;
+    int msaa_samples = 0;
+    float resolution_scale = 1.0f;
+    bool dynamic_resolution = false;
+    int target_fps = 0;
+    const char* metrics_path = NULL;
+    TextureFormat texture_format = TEXTURE_FORMAT_BC1;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--second-window") == 0) {
+            second_window = true;
+        } else if (strcmp(argv[i], "--overview") == 0) {
+            overview_view = true;
+        } else if (strcmp(argv[i], "--record") == 0 && has_value) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && has_value) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--timings") == 0 && has_value) {
+            timings_path = argv[++i];
+        } else if (strcmp(argv[i], "--hash") == 0) {
+            hash_frames = true;
+        } else if (strcmp(argv[i], "--grid") == 0 && has_value) {
+            grid_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lights") == 0 && has_value) {
+            light_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-occlusion") == 0) {
+            occlusion_culling = false;
+        } else if (strcmp(argv[i], "--no-shadows") == 0) {
+            shadows = false;
+        } else if (strcmp(argv[i], "--no-shadow-cache") == 0) {
+            cache_shadows = false;
+        } else if (strcmp(argv[i], "--textures") == 0 && has_value) {
+            texture_path = argv[++i];
+        } else if (strcmp(argv[i], "--texture-budget") == 0 && has_value) {
+            texture_budget_mb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--msaa") == 0 && has_value) {
+            msaa_samples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--resolution-scale") == 0 && has_value) {
+            resolution_scale = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--dynamic-resolution") == 0) {
+            dynamic_resolution = true;
+        } else if (strcmp(argv[i], "--target-fps") == 0 && has_value) {
+            target_fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics-port") == 0 && has_value) {
+            metrics_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics-file") == 0 && has_value) {
+            metrics_path = argv[++i];
+        } else if (strcmp(argv[i], "--make-textures") == 0 && has_value) {
+            make_textures_path = argv[++i];
+        } else if (strcmp(argv[i], "--texture-format") == 0 && has_value && texture_format_from_name(argv[i + 1], &texture_format)) {
+            i++;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            fprintf(stderr, "Usage: %s [--second-window] [--overview] [--grid N] [--lights N] [--no-occlusion] [--no-shadows | --no-shadow-cache] [--msaa N] [--resolution-scale S] [--dynamic-resolution [--target-fps N]] [--textures FILE [--texture-budget MB]] [--metrics-port PORT] [--metrics-file FILE] [--record FILE | --replay FILE [--timings FILE] [--hash]]\n", argv[0]);
+            fprintf(stderr, "       %s --make-textures FILE [--texture-format bc1|rgba8]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    // Generate the face label tile file and stop
+    if (make_textures_path) {
+        ThreadPool pool = thread_pool_create(0);
+        bool written = label_tiles_write(make_textures_path, texture_format, LABEL_TILES_LAYERS, LABEL_TILES_PAGES, pool);
+        thread_pool_destroy(pool);
+        return written ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
     // Create default configurations
     RendererConfig renderer_config = renderer_config_default();
+    renderer_config.grid_size = grid_size;
+    renderer_config.occlusion_culling = occlusion_culling;
+    if (!shadows) {
+        renderer_config.shadow_map_size = 0;
+    }
+    renderer_config.cache_shadows = cache_shadows;
+    if (light_count >= 0) {
+        renderer_config.light_count = light_count;
+    }
+    renderer_config.texture_path = texture_path;
+    if (texture_budget_mb > 0) {
+        renderer_config.texture_budget_mb = texture_budget_mb;
+    }
+    renderer_config.msaa_samples = msaa_samples;
+    renderer_config.resolution_scale = resolution_scale;
+    renderer_config.dynamic_resolution = dynamic_resolution;
+    renderer_config.target_frame_rate = target_fps;
+    renderer_config.metrics_port = metrics_port;
+    renderer_config.metrics_path = metrics_path;
     RendererWindowConfig window_config = renderer_window_config_default();
     
     // Initialize renderer with window
-    if (!renderer_init_with_window(renderer_config, window_config)) {
+    Renderer renderer = renderer_init_with_window(renderer_config, window_config);
+    if (!renderer) {
         return EXIT_FAILURE;
     }
     
-    // Run the main loop
-    renderer_run_main_loop();
+    // Optionally a picture-in-picture view from above in the top-right corner
+    if (overview_view) {
+        RendererViewConfig overview = renderer_view_config_default();
+        overview.viewport_x = 0.68f;
+        overview.viewport_y = 0.68f;
+        overview.viewport_width = 0.3f;
+        overview.viewport_height = 0.3f;
+        overview.eye_y = 10.0f;
+        overview.eye_z = 3.0f;
+        renderer_add_view(renderer, overview);
+    }
+    
+    // Optionally a second window with a side view, sharing all GPU resources
+    if (second_window) {
+        RendererWindowConfig side_window_config = renderer_window_config_default();
+        side_window_config.title = "Cube (side view)";
+        int window = renderer_add_window(renderer, side_window_config);
+        if (window >= 0) {
+            RendererViewConfig side_view = renderer_view_config_default();
+            side_view.window = window;
+            side_view.eye_x = 9.0f;
+            side_view.eye_y = 1.0f;
+            side_view.eye_z = 0.0f;
+            renderer_add_view(renderer, side_view);
+        }
+    }
+    
+    // Either replay a recording as a benchmark or run interactively
+    bool ok = true;
+    if (replay_path) {
+        ok = renderer_run_replay(renderer, replay_path, timings_path, hash_frames);
+    } else {
+        if (record_path && !renderer_start_recording(renderer, record_path)) {
+            renderer_terminate(renderer);
+            return EXIT_FAILURE;
+        }
+        renderer_run_main_loop(renderer);
+    }
     
     // Clean up
-    renderer_terminate();
+    renderer_terminate(renderer);
     
     printf("Exiting Cube application\n");
-    return EXIT_SUCCESS;
-} 
\ No newline at end of file
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -1,11 +1,24 @@
 #include "renderer.h"
 #include "../window/window.h"
 #include "../utils/shader/shader.h"
+#include "../utils/shader/shader_reload.h"
 #include "../utils/math/math.h"
 #include "../utils/objects/cube.h"
+#include "../utils/thread/thread_pool.h"
+#include "../utils/buffer/stream_buffer.h"
+#include "../utils/occlusion/occlusion_buffer.h"
+#include "../scene/scene.h"
+#include "../lighting/cluster_grid.h"
+#include "../utils/texture/virtual_texture.h"
+#include "../utils/render_target/render_target.h"
+#include "../utils/gpu_timer/gpu_timer.h"
+#include "../utils/metrics/metrics.h"
+#include "../utils/metrics/metrics_export.h"
+#include "../replay/replay.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
 #include <GLFW/glfw3.h>
 
@@ -16,45 +29,1455 @@
 #include <glad/glad.h>
 #endif
 
-// Global renderer configuration
-static RendererConfig current_config;
-
-// Window handle
-static Window window = NULL;
-
-// Shader program
-static ShaderProgram shader_program;
-
-// Cube object
-static Cube* cube = NULL;
-
-// Time tracking
-static double last_frame_time = 0.0;
-
-// Vertex shader source
-static const char* vertex_shader_source = 
-    "#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "layout (location = 1) in vec3 aColor;\n"
-    "out vec3 vertexColor;\n"
-    "uniform mat4 model;\n"
-    "uniform mat4 view;\n"
-    "uniform mat4 projection;\n"
-    "void main()\n"
-    "{\n"
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
-    "   vertexColor = aColor;\n"
-    "}\0";
-
-// Fragment shader source
-static const char* fragment_shader_source = 
-    "#version 330 core\n"
-    "in vec3 vertexColor;\n"
-    "out vec4 FragColor;\n"
-    "void main()\n"
-    "{\n"
-    "   FragColor = vec4(vertexColor, 1.0);\n"
-    "}\0";
+// Default location of the shader files, set by the build system
+#ifndef CUBE_SHADER_DIR
+#define CUBE_SHADER_DIR "shaders"
+#endif
+
+// Limits of the renderer
+#define RENDERER_MAX_WINDOWS 4
+#define RENDERER_MAX_VIEWS 8
+
+// Limits of the demo scene; the optional grid comes on top of the base nodes
+#define RENDERER_BASE_SCENE_NODES 256
+#define RENDERER_MAX_BODIES 16
+#define RENDERER_RING_CUBES 24
+#define RENDERER_MAX_GRID_SIZE 32
+
+// Placement of the grid: distance between cube centers and of its front face
+#define RENDERER_GRID_SPACING 1.25f
+#define RENDERER_GRID_FRONT_Z -6.0f
+
+// Smallest size of the streaming buffer that carries all per-frame uploads
+// It grows with the scene so several frames of data fit at once.
+#define RENDERER_STREAM_BUFFER_SIZE (4 * 1024 * 1024)
+#define RENDERER_STREAM_BUFFER_FRAMES 3
+
+// Most point lights the scene may have
+#define RENDERER_MAX_LIGHTS 16384
+
+// Depth range of every view's projection
+#define RENDERER_NEAR_PLANE 0.1f
+#define RENDERER_FAR_PLANE 100.0f
+
+// Shadow cascades of the key light per view (must match shaders/cube.frag),
+// the view depth they reach and how their splits are spread: 1 is purely
+// logarithmic, 0 evenly spaced
+#define RENDERER_SHADOW_CASCADES 4
+#define RENDERER_SHADOW_DISTANCE 50.0f
+#define RENDERER_SHADOW_SPLIT_LAMBDA 0.75f
+
+// How far towards the light a cascade reaches beyond its slice, for casters
+// outside the view
+#define RENDERER_SHADOW_CASTER_RANGE 50.0f
+
+// Smallest shadow cascade the renderer accepts, in texels per side; cascades
+// snap to whole texels and keep one free at each edge
+#define RENDERER_MIN_SHADOW_MAP_SIZE 16
+
+// Direction towards the key light; must match shaders/cube.frag
+#define RENDERER_KEY_LIGHT_X 0.3f
+#define RENDERER_KEY_LIGHT_Y 0.9f
+#define RENDERER_KEY_LIGHT_Z 0.3f
+
+// Resolution of the per-view software depth buffer used for occlusion culling
+#define RENDERER_OCCLUSION_WIDTH 256
+#define RENDERER_OCCLUSION_HEIGHT 128
+
+// Uniform buffer binding point and size of the per-view camera block
+// The block holds view and projection matrices, the viewport, the cluster
+// depth slice parameters and the view's shadow cascades.
+#define CAMERA_BLOCK_BINDING 0
+#define CAMERA_BLOCK_SIZE (116 * sizeof(float))
+
+// Shadow passes bind a light camera that only has the two matrices
+#define LIGHT_CAMERA_SIZE (32 * sizeof(float))
+
+// Texture units of the textures the shaders read
+#define MODEL_TEXTURE_UNIT 0
+#define CLUSTER_TEXTURE_UNIT 1
+#define PAGE_CACHE_TEXTURE_UNIT 2
+#define PAGE_TABLE_TEXTURE_UNIT 3
+#define SHADOW_MAP_TEXTURE_UNIT 4
+
+// The texture feedback pass draws each view at this fraction of its size
+#define RENDERER_FEEDBACK_DIVISOR 8
+
+// Range of the frame time histograms, in seconds
+#define RENDERER_METRICS_MIN_TIME 1e-5
+#define RENDERER_METRICS_MAX_TIME 10.0
+
+// Seconds between queries of the driver's free GPU memory, which may stall
+#define RENDERER_METRICS_MEMORY_INTERVAL 1.0
+
+// Free video memory queries (in kilobytes) of the NVX_gpu_memory_info and
+// ATI_meminfo extensions
+#define GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#define TEXTURE_FREE_MEMORY_ATI 0x87FC
+
+// Refresh rate assumed when the monitor does not report one
+#define RENDERER_DEFAULT_REFRESH_RATE 60
+
+// Dynamic resolution aims for this fraction of the frame budget, follows
+// the GPU time with this smoothing weight for each new measurement and
+// changes the scale by at most this much per frame
+#define RENDERER_RESOLUTION_HEADROOM 0.9
+#define RENDERER_RESOLUTION_SMOOTHING 0.2
+#define RENDERER_RESOLUTION_MAX_STEP 0.05
+
+// Longest GPU time a frame is believed to take, in seconds; some drivers
+// report nonsense for their first timer query
+#define RENDERER_MAX_GPU_FRAME_TIME 10.0
+
+// Lowest resolution scale the renderer accepts
+#define RENDERER_MIN_RESOLUTION_SCALE 0.1f
+
+// Vertex attribute carrying the instance index
+#define INSTANCE_ATTRIBUTE 2
+
+// Radius of the sphere around a unit cube
+#define CUBE_BOUNDING_RADIUS 0.8660254f
+
+// A cube that spins about its own center while orbiting its parent
+typedef struct {
+    SceneNode pivot;   // Rotates about the parent's anchor
+    SceneNode body;    // The drawn cube
+    float orbit_speed; // Relative to the configured rotation speed
+    float spin_speed;  // Relative to the configured rotation speed
+    float scale;
+} Body;
+
+// A point light circling the vertical axis while bobbing up and down
+typedef struct {
+    float orbit_radius;
+    float orbit_speed; // Relative to the configured rotation speed
+    float height;
+    float phase;
+    float radius;      // Distance at which the light fades out completely
+    float color[3];
+} Light;
+
+// A window and the per-context objects needed to draw into it
+typedef struct {
+    Window window;      // NULL once the window has been closed
+    unsigned int vao;   // Vertex arrays are not shared between contexts
+    int width;          // Framebuffer size for the current frame
+    int height;
+    
+    // Offscreen drawing, NULL when the views are drawn straight into the
+    // window. The views fill the render size at the bottom left of the
+    // scene target, which is resolved into the resolve target when it is
+    // multisampled and then scaled up to the window. Framebuffer objects are
+    // not shared, so every window has its own.
+    RenderTarget scene_target;
+    RenderTarget resolve_target;
+    int render_width;   // Size the views are drawn at this frame
+    int render_height;
+} RendererWindow;
+
+// The key light's view of one depth slice of a view, kept in a layer of the
+// shadow map
+typedef struct {
+    float split;          // Farthest view depth the cascade covers
+    float texel_size;     // World-space size of a shadow map texel
+    float projection[16]; // Light-space box of the cascade
+    bool valid;           // The layer holds the casters seen through projection
+    bool draw;            // Whether the layer is redrawn this frame
+    int* casters;         // Instances inside the box, when redrawn
+    int caster_count;
+    
+    // Where the cascade's data lives in the streaming buffer this frame
+    size_t camera_offset;
+    size_t caster_offset;
+} ShadowCascade;
+
+// Telemetry of the running renderer; all NULL unless it is exported
+typedef struct {
+    Metric frames;
+    Metric dropped_frames;
+    Metric frame_time;
+    Metric frame_cpu_time;
+    Metric frame_gpu_time;
+    Metric resolution_scale;
+    Metric draw_calls;
+    Metric draw_calls_total;
+    Metric visible_instances;
+    Metric shadow_cascades_drawn;
+    Metric texture_pages_resident;
+    Metric gl_memory;
+    Metric gl_memory_available;
+} RendererMetrics;
+
+// A camera drawn into part of a window
+typedef struct {
+    RendererViewConfig config;
+    
+    // Filled in by the culling pass; the visible set of one frame is drawn
+    // into the occlusion buffer as the occluders of the next
+    float view[16];
+    float projection[16];
+    int* visible;
+    int visible_count;
+    OcclusionBuffer occlusion; // NULL when occlusion culling is off
+    
+    // Light lists of the view's clusters
+    ClusterGrid clusters;
+    
+    // Shadow map layers of the view
+    ShadowCascade cascades[RENDERER_SHADOW_CASCADES];
+    
+    // Where this view's data lives in the streaming buffer this frame
+    size_t camera_offset;
+    size_t visible_offset;
+    size_t cluster_offset;
+} RendererView;
+
+// Define the actual renderer implementation structure
+struct RendererImpl {
+    RendererConfig config;
+    
+    // Windows share one GL object namespace; index 0 is the main window
+    RendererWindow windows[RENDERER_MAX_WINDOWS];
+    int window_count;
+    
+    RendererView views[RENDERER_MAX_VIEWS];
+    int view_count;
+    
+    // Background recompiler of every program (NULL when disabled), and the
+    // shader program with its id in it (-1 when not watched)
+    ShaderReloader shader_reloader;
+    ShaderProgram shader_program;
+    int shader_reload_id;
+    
+    // Streamed face labels and the program of their feedback pass; NULL
+    // and 0 when the scene is untextured
+    VirtualTexture virtual_texture;
+    ShaderProgram feedback_program;
+    int feedback_reload_id;
+    
+    // Key light shadows: RENDERER_SHADOW_CASCADES layers of the shadow map
+    // per view, drawn with a depth-only program (NULL and 0 without shadows)
+    RenderTarget shadow_target;
+    ShaderProgram shadow_program;
+    int shadow_reload_id;
+    float light_view[16];
+    int shadow_cascades_drawn; // Since the last replay started, for its summary
+    int shadow_cascades_used;
+    
+    // Cube object (shared mesh for every cube in the scene)
+    Cube* cube;
+    
+    // Transform hierarchy of the scene
+    Scene scene;
+    Body bodies[RENDERER_MAX_BODIES];
+    int body_count;
+    
+    // Nodes drawn with the cube mesh and their world-space bounding spheres,
+    // this frame and last
+    SceneNode* instances;
+    float* instance_bounds;
+    float* previous_bounds;
+    int instance_count;
+    int instance_capacity;
+    
+    // Instances that moved in the last scene update
+    int* changed_instances;
+    int changed_count;
+    
+    // Point lights and, each frame, their world-space position and radius
+    Light* lights;
+    float* light_spheres;
+    int light_count;
+    
+    // Workers for the parallel passes
+    ThreadPool thread_pool;
+    
+    // Per-frame uploads; model matrices are read through a buffer texture
+    StreamBuffer stream_buffer;
+    unsigned int model_texture;
+    size_t model_offset;
+    float* mapped_models;
+    
+    // Light data shares the model matrices' buffer texture; cluster tables and
+    // light lists go through a second, integer, view of the stream
+    unsigned int cluster_texture;
+    size_t light_offset;
+    float* mapped_lights;
+    size_t uniform_alignment;
+    
+    // Time tracking
+    double last_frame_time;
+    double animation_time;
+    double animated_time; // Animation time the scene was last posed at
+    bool paused;
+    double refresh_interval; // Seconds between display refreshes
+    
+    // Fraction of the window size the views are drawn at, steered towards
+    // the target frame time by the GPU time of recent frames (NULL timer
+    // when frames are not timed)
+    float resolution_scale;
+    GpuTimer gpu_timer;
+    double gpu_time_average;
+    bool resolution_fixed; // Replays that hash their output keep the scale
+    
+    // Metrics and their exporter (NULL unless exported)
+    MetricsRegistry metrics_registry;
+    MetricsExporter metrics_exporter;
+    RendererMetrics metrics;
+    int frame_draw_calls;
+    unsigned int free_memory_query; // 0 when the driver has none
+    double next_memory_query;
+    
+    // Input recording (NULL when not recording) and the frame being captured
+    ReplayWriter recorder;
+    ReplayFrame recorded_frame;
+    
+    // Framebuffer size imposed on the main window during replay (0 when live),
+    // and the target of that size the main window draws into meanwhile, so
+    // replays do not depend on the size the window really has
+    int forced_width;
+    int forced_height;
+    RenderTarget replay_target;
+};
+
+// Add an orbiting body under parent_anchor and return its own anchor,
+// which children use as the center of their orbit
+static SceneNode add_body(Renderer renderer, SceneNode parent_anchor, float radius, float scale, float orbit_speed, float spin_speed) {
+    float identity[16], offset[16];
+    matrix_identity(identity);
+    matrix_translate(offset, radius, 0.0f, 0.0f);
+    
+    SceneNode pivot = scene_add_node(renderer->scene, parent_anchor, identity);
+    SceneNode anchor = scene_add_node(renderer->scene, pivot, offset);
+    SceneNode body = scene_add_node(renderer->scene, anchor, identity);
+    if (body == SCENE_NODE_NONE || renderer->body_count >= RENDERER_MAX_BODIES) {
+        return SCENE_NODE_NONE;
+    }
+    
+    Body* b = &renderer->bodies[renderer->body_count++];
+    b->pivot = pivot;
+    b->body = body;
+    b->orbit_speed = orbit_speed;
+    b->spin_speed = spin_speed;
+    b->scale = scale;
+    
+    renderer->instances[renderer->instance_count++] = body;
+    return anchor;
+}
+
+// Add a static block of grid_size^3 cubes behind the scene
+// Only its front layer can be seen from the default cameras.
+static bool add_grid(Renderer renderer, int grid_size) {
+    float extent = (float)(grid_size - 1) * RENDERER_GRID_SPACING;
+    float origin[16];
+    matrix_translate(origin, -0.5f * extent, -0.5f * extent, RENDERER_GRID_FRONT_Z - extent);
+    SceneNode grid = scene_add_node(renderer->scene, SCENE_NODE_NONE, origin);
+    
+    for (int z = 0; z < grid_size; z++) {
+        for (int y = 0; y < grid_size; y++) {
+            for (int x = 0; x < grid_size; x++) {
+                float offset[16];
+                matrix_translate(offset, (float)x * RENDERER_GRID_SPACING, (float)y * RENDERER_GRID_SPACING,
+                                 (float)z * RENDERER_GRID_SPACING);
+                SceneNode node = scene_add_node(renderer->scene, grid, offset);
+                if (node == SCENE_NODE_NONE) {
+                    return false;
+                }
+                renderer->instances[renderer->instance_count++] = node;
+            }
+        }
+    }
+    
+    return true;
+}
+
+// Build the demo scene: a sun with orbiting planets and moons, surrounded by
+// a ring of static cubes that never need their transforms recomputed
+static bool build_scene(Renderer renderer) {
+    int grid_size = renderer->config.grid_size;
+    if (grid_size < 0) grid_size = 0;
+    if (grid_size > RENDERER_MAX_GRID_SIZE) grid_size = RENDERER_MAX_GRID_SIZE;
+    int grid_cubes = grid_size * grid_size * grid_size;
+    
+    renderer->scene = scene_create(RENDERER_BASE_SCENE_NODES + grid_cubes + 1);
+    renderer->instance_capacity = RENDERER_BASE_SCENE_NODES + grid_cubes;
+    renderer->instances = (SceneNode*)malloc((size_t)renderer->instance_capacity * sizeof(SceneNode));
+    renderer->instance_bounds = (float*)malloc((size_t)renderer->instance_capacity * 4 * sizeof(float));
+    renderer->previous_bounds = (float*)calloc((size_t)renderer->instance_capacity * 4, sizeof(float));
+    renderer->changed_instances = (int*)malloc((size_t)renderer->instance_capacity * sizeof(int));
+    if (!renderer->scene || !renderer->instances || !renderer->instance_bounds || !renderer->previous_bounds ||
+        !renderer->changed_instances) {
+        return false;
+    }
+    
+    SceneNode sun = add_body(renderer, SCENE_NODE_NONE, 0.0f, 1.0f, 0.0f, 1.0f);
+    SceneNode planet = add_body(renderer, sun, 2.2f, 0.45f, 0.6f, 1.5f);
+    add_body(renderer, planet, 0.7f, 0.15f, 2.0f, 2.0f);
+    SceneNode outer_planet = add_body(renderer, sun, 3.2f, 0.3f, 0.35f, 1.2f);
+    add_body(renderer, outer_planet, 0.5f, 0.12f, -1.6f, 2.5f);
+    if (outer_planet == SCENE_NODE_NONE) {
+        return false;
+    }
+    
+    float identity[16];
+    matrix_identity(identity);
+    SceneNode ring = scene_add_node(renderer->scene, SCENE_NODE_NONE, identity);
+    for (int i = 0; i < RENDERER_RING_CUBES; i++) {
+        float rotation[16], offset[16], scaling[16], temp[16], local[16];
+        matrix_rotate_y(rotation, (float)i * (2.0f * 3.14159f / RENDERER_RING_CUBES));
+        matrix_translate(offset, 4.2f, 0.0f, 0.0f);
+        matrix_scale(scaling, 0.2f, 0.2f, 0.2f);
+        matrix_multiply(temp, offset, rotation);
+        matrix_multiply(local, scaling, temp);
+        
+        SceneNode node = scene_add_node(renderer->scene, ring, local);
+        if (node == SCENE_NODE_NONE) {
+            return false;
+        }
+        renderer->instances[renderer->instance_count++] = node;
+    }
+    
+    if (grid_size > 0 && !add_grid(renderer, grid_size)) {
+        return false;
+    }
+    
+    return true;
+}
+
+// Small deterministic generator so every run gets the same lights
+static float random_float(unsigned int* state, float min, float max) {
+    *state = *state * 1664525u + 1013904223u;
+    return min + (max - min) * (float)(*state >> 8) / 16777216.0f;
+}
+
+// Scatter point lights of random colors around the scene
+static bool build_lights(Renderer renderer) {
+    int count = renderer->config.light_count;
+    if (count < 0) count = 0;
+    if (count > RENDERER_MAX_LIGHTS) count = RENDERER_MAX_LIGHTS;
+    if (count == 0) {
+        return true;
+    }
+    
+    renderer->lights = (Light*)malloc((size_t)count * sizeof(Light));
+    renderer->light_spheres = (float*)malloc((size_t)count * 4 * sizeof(float));
+    if (!renderer->lights || !renderer->light_spheres) {
+        return false;
+    }
+    
+    unsigned int seed = 12345u;
+    for (int i = 0; i < count; i++) {
+        Light* light = &renderer->lights[i];
+        light->orbit_radius = random_float(&seed, 1.5f, 12.0f);
+        light->orbit_speed = random_float(&seed, -0.5f, 0.5f);
+        light->height = random_float(&seed, -3.0f, 5.0f);
+        light->phase = random_float(&seed, 0.0f, 2.0f * 3.14159f);
+        light->radius = random_float(&seed, 1.0f, 2.5f);
+        
+        // Saturated hue around the color wheel
+        float hue = random_float(&seed, 0.0f, 3.0f);
+        for (int c = 0; c < 3; c++) {
+            float distance = fabsf(hue - (float)c);
+            distance = fminf(distance, 3.0f - distance);
+            light->color[c] = 0.8f * fmaxf(0.0f, 1.0f - distance) + 0.2f;
+        }
+    }
+    
+    renderer->light_count = count;
+    return true;
+}
+
+// Update the local transforms of the moving nodes
+static void animate_scene(Renderer renderer, float time) {
+    for (int i = 0; i < renderer->body_count; i++) {
+        Body* b = &renderer->bodies[i];
+        float angle = time * renderer->config.rotation_speed;
+        
+        if (b->orbit_speed != 0.0f) {
+            float orbit[16];
+            matrix_rotate_y(orbit, angle * b->orbit_speed);
+            scene_set_local_transform(renderer->scene, b->pivot, orbit);
+        }
+        
+        // Same tumbling motion as a lone cube: rotate about Y and half as fast about X
+        float rotation_y[16], rotation_x[16], scaling[16], temp[16], local[16];
+        matrix_rotate_y(rotation_y, angle * b->spin_speed);
+        matrix_rotate_x(rotation_x, angle * b->spin_speed * 0.5f);
+        matrix_scale(scaling, b->scale, b->scale, b->scale);
+        matrix_multiply(temp, rotation_y, rotation_x);
+        matrix_multiply(local, scaling, temp);
+        scene_set_local_transform(renderer->scene, b->body, local);
+    }
+}
+
+// Set up per-context state for a freshly created window (its context is current)
+static bool setup_window_context(Renderer renderer, RendererWindow* window) {
+    window->vao = cube_create_vertex_array(renderer->cube);
+    if (!window->vao) {
+        return false;
+    }
+    
+    // The instance index is streamed per view; only the layout is fixed here
+    glBindVertexArray(window->vao);
+    glEnableVertexAttribArray(INSTANCE_ATTRIBUTE);
+    glVertexAttribDivisor(INSTANCE_ATTRIBUTE, 1);
+    glBindVertexArray(0);
+    
+    // Enable depth testing
+    glEnable(GL_DEPTH_TEST);
+    
+    window_setup_callbacks(window->window);
+    
+    // Draw offscreen when the views are multisampled or scaled; the targets
+    // follow the window's size from then on
+    if (renderer->config.msaa_samples > 1 || renderer->config.resolution_scale < 1.0f ||
+        renderer->config.dynamic_resolution) {
+        RenderTargetConfig config = render_target_config_default();
+        window_get_framebuffer_size(window->window, &config.width, &config.height);
+        config.width = config.width > 0 ? config.width : 1;
+        config.height = config.height > 0 ? config.height : 1;
+        config.samples = renderer->config.msaa_samples;
+        window->scene_target = render_target_create(config);
+        if (window->scene_target && render_target_get_samples(window->scene_target) > 1) {
+            config.samples = 0;
+            config.depth = RENDER_TARGET_DEPTH_NONE;
+            window->resolve_target = render_target_create(config);
+            if (!window->resolve_target) {
+                render_target_destroy(window->scene_target);
+                window->scene_target = NULL;
+            }
+        }
+        if (!window->scene_target) {
+            fprintf(stderr, "Drawing straight into the window instead\n");
+        }
+    }
+    return true;
+}
+
+// Release a window's offscreen targets; its context must be current
+static void release_window_targets(RendererWindow* window) {
+    render_target_destroy(window->scene_target);
+    render_target_destroy(window->resolve_target);
+    window->scene_target = NULL;
+    window->resolve_target = NULL;
+}
+
+// Point the shader at the shared resources; needed again after every reload
+static void setup_shader_program(Renderer renderer) {
+    shader_bind_uniform_block(renderer->shader_program, "Camera", CAMERA_BLOCK_BINDING);
+    
+    // Every sampler needs a unit of its own, even when it is never read
+    shader_use_program(renderer->shader_program);
+    shader_set_int(renderer->shader_program, "pageCache", PAGE_CACHE_TEXTURE_UNIT);
+    shader_set_int(renderer->shader_program, "pageTable", PAGE_TABLE_TEXTURE_UNIT);
+    shader_set_int(renderer->shader_program, "shadowMap", SHADOW_MAP_TEXTURE_UNIT);
+    shader_set_int(renderer->shader_program, "virtualTexturing", renderer->virtual_texture != NULL);
+    shader_set_int(renderer->shader_program, "virtualLayers", 0);
+    shader_use_program(0);
+}
+
+// Same for the texture feedback program
+static void setup_feedback_program(Renderer renderer) {
+    shader_bind_uniform_block(renderer->feedback_program, "Camera", CAMERA_BLOCK_BINDING);
+}
+
+// And for the shadow program, which reads each cascade's light camera
+static void setup_shadow_program(Renderer renderer) {
+    shader_bind_uniform_block(renderer->shadow_program, "Camera", CAMERA_BLOCK_BINDING);
+}
+
+// Pixel rectangle (x, y, width, height) of a view within its window
+static void get_view_rect(Renderer renderer, const RendererView* view, int* rect) {
+    const RendererWindow* window = &renderer->windows[view->config.window];
+    rect[0] = (int)(view->config.viewport_x * (float)window->render_width);
+    rect[1] = (int)(view->config.viewport_y * (float)window->render_height);
+    rect[2] = (int)(view->config.viewport_width * (float)window->render_width);
+    rect[3] = (int)(view->config.viewport_height * (float)window->render_height);
+}
+
+// Copy model matrices into the mapped streaming buffer and compute bounds
+static void upload_instances(void* context, int begin, int end) {
+    Renderer renderer = (Renderer)context;
+    
+    for (int i = begin; i < end; i++) {
+        const float* world = scene_get_world_transform(renderer->scene, renderer->instances[i]);
+        memcpy(renderer->mapped_models + (size_t)i * 16, world, 16 * sizeof(float));
+        
+        // The sphere scales with the longest basis vector
+        float scale_x = world[0] * world[0] + world[1] * world[1] + world[2] * world[2];
+        float scale_y = world[4] * world[4] + world[5] * world[5] + world[6] * world[6];
+        float scale_z = world[8] * world[8] + world[9] * world[9] + world[10] * world[10];
+        float max_scale = fmaxf(scale_x, fmaxf(scale_y, scale_z));
+        
+        float* bounds = renderer->instance_bounds + (size_t)i * 4;
+        bounds[0] = world[12];
+        bounds[1] = world[13];
+        bounds[2] = world[14];
+        bounds[3] = sqrtf(max_scale) * CUBE_BOUNDING_RADIUS;
+    }
+}
+
+// Move the lights and copy them into the mapped streaming buffer
+static void upload_lights(void* context, int begin, int end) {
+    Renderer renderer = (Renderer)context;
+    float time = (float)renderer->animation_time * renderer->config.rotation_speed;
+    
+    for (int i = begin; i < end; i++) {
+        const Light* light = &renderer->lights[i];
+        float angle = light->phase + time * light->orbit_speed;
+        float* sphere = renderer->light_spheres + (size_t)i * 4;
+        sphere[0] = light->orbit_radius * cosf(angle);
+        sphere[1] = light->height + 0.5f * sinf(angle * 3.0f);
+        sphere[2] = light->orbit_radius * sinf(angle);
+        sphere[3] = light->radius;
+        
+        // Two RGBA32F texels: position and radius, then color
+        float* texels = renderer->mapped_lights + (size_t)i * 8;
+        memcpy(texels, sphere, 4 * sizeof(float));
+        texels[4] = light->color[0];
+        texels[5] = light->color[1];
+        texels[6] = light->color[2];
+        texels[7] = 0.0f;
+    }
+}
+
+// Compute the camera of each view and the instances inside its frustum
+static void cull_views(void* context, int begin, int end) {
+    Renderer renderer = (Renderer)context;
+    
+    for (int v = begin; v < end; v++) {
+        RendererView* view = &renderer->views[v];
+        int previous_count = view->visible_count;
+        view->visible_count = 0;
+        
+        int rect[4];
+        get_view_rect(renderer, view, rect);
+        if (!renderer->windows[view->config.window].window || rect[2] <= 0 || rect[3] <= 0) {
+            continue;
+        }
+        
+        const RendererViewConfig* config = &view->config;
+        matrix_look_at(view->view,
+                      config->eye_x, config->eye_y, config->eye_z,
+                      config->target_x, config->target_y, config->target_z,
+                      0.0f, 1.0f, 0.0f);
+        float aspect_ratio = (float)rect[2] / (float)rect[3];
+        matrix_perspective(view->projection, config->fov_degrees * (3.14159f / 180.0f), aspect_ratio,
+                           RENDERER_NEAR_PLANE, RENDERER_FAR_PLANE);
+        
+        // matrix_multiply(r, a, b) yields b * a, so this is projection * view
+        float view_projection[16];
+        matrix_multiply(view_projection, view->view, view->projection);
+        Frustum frustum;
+        frustum_extract(&frustum, view_projection);
+        
+        // Last frame's visible objects, at this frame's positions, are almost
+        // all of what is in front; whatever they hide is not drawn
+        OcclusionBuffer occlusion = view->occlusion;
+        if (occlusion) {
+            occlusion_buffer_begin(occlusion, view_projection);
+            for (int k = 0; k < previous_count; k++) {
+                SceneNode node = renderer->instances[view->visible[k]];
+                occlusion_buffer_draw_box(occlusion, scene_get_world_transform(renderer->scene, node));
+            }
+            occlusion_buffer_build_pyramid(occlusion);
+        }
+        
+        for (int i = 0; i < renderer->instance_count; i++) {
+            const float* bounds = renderer->instance_bounds + (size_t)i * 4;
+            if (!frustum_contains_sphere(&frustum, bounds[0], bounds[1], bounds[2], bounds[3])) {
+                continue;
+            }
+            if (occlusion && !occlusion_buffer_test_box(occlusion,
+                    scene_get_world_transform(renderer->scene, renderer->instances[i]))) {
+                continue;
+            }
+            view->visible[view->visible_count++] = i;
+        }
+    }
+}
+
+// Farthest view depth of a shadow cascade; cascade -1 ends at the near plane
+static float cascade_split(int cascade) {
+    if (cascade < 0) return RENDERER_NEAR_PLANE;
+    
+    float fraction = (float)(cascade + 1) / (float)RENDERER_SHADOW_CASCADES;
+    float logarithmic = RENDERER_NEAR_PLANE * powf(RENDERER_SHADOW_DISTANCE / RENDERER_NEAR_PLANE, fraction);
+    float even = RENDERER_NEAR_PLANE + (RENDERER_SHADOW_DISTANCE - RENDERER_NEAR_PLANE) * fraction;
+    return RENDERER_SHADOW_SPLIT_LAMBDA * logarithmic + (1.0f - RENDERER_SHADOW_SPLIT_LAMBDA) * even;
+}
+
+// Place the shadow cascades of every view and collect the casters of those
+// that must be redrawn; one job per cascade
+static void update_cascades(void* context, int begin, int end) {
+    Renderer renderer = (Renderer)context;
+    int size = renderer->config.shadow_map_size;
+    const float* light = renderer->light_view;
+    
+    for (int job = begin; job < end; job++) {
+        RendererView* view = &renderer->views[job / RENDERER_SHADOW_CASCADES];
+        int index = job % RENDERER_SHADOW_CASCADES;
+        ShadowCascade* cascade = &view->cascades[index];
+        cascade->draw = false;
+        if (view->visible_count == 0) continue;
+        
+        // Bounding sphere of the cascade's slice of the view frustum; its size
+        // only depends on the slice, not on where the view looks
+        const RendererViewConfig* config = &view->config;
+        int rect[4];
+        get_view_rect(renderer, view, rect);
+        float tan_y = tanf(config->fov_degrees * (3.14159f / 180.0f) * 0.5f);
+        float tan_x = tan_y * (float)rect[2] / (float)rect[3];
+        float spread = tan_x * tan_x + tan_y * tan_y; // Squared corner distance from the axis per unit depth
+        float near = cascade_split(index - 1);
+        float far = cascade_split(index);
+        float center = fminf(0.5f * (near + far) * (1.0f + spread), far);
+        float radius = sqrtf(far * far * spread + (far - center) * (far - center));
+        radius = ceilf(radius * 16.0f) / 16.0f;
+        
+        float forward[3] = {
+            config->target_x - config->eye_x,
+            config->target_y - config->eye_y,
+            config->target_z - config->eye_z
+        };
+        float length = sqrtf(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+        float world_x = config->eye_x + forward[0] / length * center;
+        float world_y = config->eye_y + forward[1] / length * center;
+        float world_z = config->eye_z + forward[2] / length * center;
+        
+        // Move the box in whole texels so static casters always land on the
+        // same texels; a texel of margin keeps the sphere inside after snapping
+        float texel = 2.0f * radius / (float)(size - 2);
+        float half = 0.5f * texel * (float)size;
+        float x = floorf((light[0] * world_x + light[4] * world_y + light[8] * world_z) / texel) * texel;
+        float y = floorf((light[1] * world_x + light[5] * world_y + light[9] * world_z) / texel) * texel;
+        float z = floorf((light[2] * world_x + light[6] * world_y + light[10] * world_z) / texel) * texel;
+        float projection[16];
+        matrix_orthographic(projection, x - half, x + half, y - half, y + half,
+                            -z - half - RENDERER_SHADOW_CASTER_RANGE, -z + half);
+        cascade->split = far;
+        cascade->texel_size = texel;
+        
+        float view_projection[16];
+        matrix_multiply(view_projection, renderer->light_view, projection);
+        Frustum frustum;
+        frustum_extract(&frustum, view_projection);
+        
+        // A cached layer stays valid while its box is unchanged and nothing
+        // that moved was inside it, either now or in the previous frame
+        bool draw = !renderer->config.cache_shadows || !cascade->valid ||
+                    memcmp(projection, cascade->projection, sizeof(projection)) != 0;
+        for (int k = 0; k < renderer->changed_count && !draw; k++) {
+            const float* now = renderer->instance_bounds + (size_t)renderer->changed_instances[k] * 4;
+            const float* before = renderer->previous_bounds + (size_t)renderer->changed_instances[k] * 4;
+            draw = frustum_contains_sphere(&frustum, now[0], now[1], now[2], now[3]) ||
+                   frustum_contains_sphere(&frustum, before[0], before[1], before[2], before[3]);
+        }
+        if (!draw) continue;
+        
+        cascade->draw = true;
+        cascade->valid = false;
+        memcpy(cascade->projection, projection, sizeof(projection));
+        cascade->caster_count = 0;
+        for (int i = 0; i < renderer->instance_count; i++) {
+            const float* bounds = renderer->instance_bounds + (size_t)i * 4;
+            if (frustum_contains_sphere(&frustum, bounds[0], bounds[1], bounds[2], bounds[3])) {
+                cascade->casters[cascade->caster_count++] = i;
+            }
+        }
+    }
+}
+
+// Make room in the shadow map for the cascades of every view; a new map
+// starts out empty. Shadows are turned off if it cannot be created.
+static bool prepare_shadow_target(Renderer renderer) {
+    int layers = renderer->view_count * RENDERER_SHADOW_CASCADES;
+    if (renderer->shadow_target && render_target_get_layers(renderer->shadow_target) >= layers) {
+        return true;
+    }
+    
+    render_target_destroy(renderer->shadow_target);
+    RenderTargetConfig config = render_target_config_default();
+    config.width = renderer->config.shadow_map_size;
+    config.height = renderer->config.shadow_map_size;
+    config.layers = layers;
+    config.color = RENDER_TARGET_COLOR_NONE;
+    config.depth = RENDER_TARGET_DEPTH_TEXTURE;
+    renderer->shadow_target = render_target_create(config);
+    if (!renderer->shadow_target) {
+        fprintf(stderr, "Shadows disabled\n");
+        renderer->config.shadow_map_size = 0;
+        return false;
+    }
+    
+    for (int v = 0; v < renderer->view_count; v++) {
+        for (int c = 0; c < RENDERER_SHADOW_CASCADES; c++) {
+            renderer->views[v].cascades[c].valid = false;
+        }
+    }
+    return true;
+}
+
+// Upload everything the views read this frame; returns false if out of space
+static bool upload_frame_data(Renderer renderer) {
+    // Last frame's bounds stay around for the shadow cache
+    float* bounds = renderer->previous_bounds;
+    renderer->previous_bounds = renderer->instance_bounds;
+    renderer->instance_bounds = bounds;
+    
+    // One copy of the scene serves every view in every window
+    renderer->mapped_models = (float*)stream_buffer_map(renderer->stream_buffer,
+        (size_t)renderer->instance_count * 16 * sizeof(float), 16, &renderer->model_offset);
+    if (!renderer->mapped_models) {
+        return false;
+    }
+    thread_pool_parallel_for(renderer->thread_pool, renderer->instance_count, 64, upload_instances, renderer);
+    stream_buffer_unmap(renderer->stream_buffer);
+    renderer->mapped_models = NULL;
+    
+    renderer->changed_count = 0;
+    for (int i = 0; i < renderer->instance_count; i++) {
+        if (scene_node_changed(renderer->scene, renderer->instances[i])) {
+            renderer->changed_instances[renderer->changed_count++] = i;
+        }
+    }
+    
+    // Lights are shared by all views too
+    if (renderer->light_count > 0) {
+        renderer->mapped_lights = (float*)stream_buffer_map(renderer->stream_buffer,
+            (size_t)renderer->light_count * 8 * sizeof(float), 16, &renderer->light_offset);
+        if (!renderer->mapped_lights) {
+            return false;
+        }
+        thread_pool_parallel_for(renderer->thread_pool, renderer->light_count, 256, upload_lights, renderer);
+        stream_buffer_unmap(renderer->stream_buffer);
+        renderer->mapped_lights = NULL;
+    }
+    
+    // Per-view cameras and visibility, computed in parallel
+    thread_pool_parallel_for(renderer->thread_pool, renderer->view_count, 1, cull_views, renderer);
+    
+    // Then the shadow cascades that follow those cameras
+    if (renderer->config.shadow_map_size > 0 && prepare_shadow_target(renderer)) {
+        thread_pool_parallel_for(renderer->thread_pool, renderer->view_count * RENDERER_SHADOW_CASCADES, 1,
+                                 update_cascades, renderer);
+    }
+    
+    for (int v = 0; v < renderer->view_count; v++) {
+        RendererView* view = &renderer->views[v];
+        if (view->visible_count == 0) continue;
+        
+        // Sort the lights into the view's clusters, spread over the pool
+        int index_count = cluster_grid_assign(view->clusters, renderer->thread_pool, view->view, view->projection,
+                                              RENDERER_NEAR_PLANE, RENDERER_FAR_PLANE,
+                                              renderer->light_spheres, renderer->light_count);
+        unsigned int* cluster_data = (unsigned int*)stream_buffer_map(renderer->stream_buffer,
+            ((size_t)CLUSTER_GRID_COUNT * 2 + (size_t)index_count) * sizeof(unsigned int),
+            sizeof(unsigned int), &view->cluster_offset);
+        if (!cluster_data) {
+            return false;
+        }
+        cluster_grid_write(view->clusters, renderer->thread_pool, cluster_data);
+        stream_buffer_unmap(renderer->stream_buffer);
+        
+        float* camera = (float*)stream_buffer_map(renderer->stream_buffer, CAMERA_BLOCK_SIZE,
+                                                  renderer->uniform_alignment, &view->camera_offset);
+        if (!camera) {
+            return false;
+        }
+        int rect[4];
+        get_view_rect(renderer, view, rect);
+        memcpy(camera, view->view, 16 * sizeof(float));
+        memcpy(camera + 16, view->projection, 16 * sizeof(float));
+        camera[32] = (float)rect[0];
+        camera[33] = (float)rect[1];
+        camera[34] = 1.0f / (float)rect[2];
+        camera[35] = 1.0f / (float)rect[3];
+        cluster_grid_get_slice_params(view->clusters, &camera[36], &camera[37]);
+        camera[38] = 0.0f;
+        camera[39] = 0.0f;
+        
+        // Cascades map world positions to shadow map coordinates in [0, 1]
+        float shadow[RENDERER_SHADOW_CASCADES * 16 + 12];
+        memset(shadow, 0, sizeof(shadow));
+        for (int c = 0; c < RENDERER_SHADOW_CASCADES; c++) {
+            ShadowCascade* cascade = &view->cascades[c];
+            float* matrix = shadow + c * 16;
+            matrix_multiply(matrix, renderer->light_view, cascade->projection);
+            for (int column = 0; column < 4; column++) {
+                for (int row = 0; row < 3; row++) {
+                    matrix[column * 4 + row] = 0.5f * (matrix[column * 4 + row] + matrix[column * 4 + 3]);
+                }
+            }
+            shadow[RENDERER_SHADOW_CASCADES * 16 + c] = cascade->split;
+            shadow[RENDERER_SHADOW_CASCADES * 16 + 4 + c] = cascade->texel_size;
+        }
+        memcpy(camera + 40, shadow, sizeof(shadow));
+        camera[112] = renderer->shadow_target ? (float)(v * RENDERER_SHADOW_CASCADES) : -1.0f;
+        camera[113] = 0.0f;
+        camera[114] = 0.0f;
+        camera[115] = 0.0f;
+        stream_buffer_unmap(renderer->stream_buffer);
+        
+        unsigned int* visible = (unsigned int*)stream_buffer_map(renderer->stream_buffer,
+            (size_t)view->visible_count * sizeof(unsigned int), sizeof(unsigned int), &view->visible_offset);
+        if (!visible) {
+            return false;
+        }
+        for (int i = 0; i < view->visible_count; i++) {
+            visible[i] = (unsigned int)view->visible[i];
+        }
+        stream_buffer_unmap(renderer->stream_buffer);
+        
+        // Light cameras and casters of the cascades to redraw
+        for (int c = 0; c < RENDERER_SHADOW_CASCADES; c++) {
+            ShadowCascade* cascade = &view->cascades[c];
+            if (!cascade->draw || cascade->caster_count == 0) continue;
+            
+            float* light_camera = (float*)stream_buffer_map(renderer->stream_buffer, LIGHT_CAMERA_SIZE,
+                                                            renderer->uniform_alignment, &cascade->camera_offset);
+            if (!light_camera) {
+                return false;
+            }
+            memcpy(light_camera, renderer->light_view, 16 * sizeof(float));
+            memcpy(light_camera + 16, cascade->projection, 16 * sizeof(float));
+            stream_buffer_unmap(renderer->stream_buffer);
+            
+            unsigned int* casters = (unsigned int*)stream_buffer_map(renderer->stream_buffer,
+                (size_t)cascade->caster_count * sizeof(unsigned int), sizeof(unsigned int), &cascade->caster_offset);
+            if (!casters) {
+                return false;
+            }
+            for (int i = 0; i < cascade->caster_count; i++) {
+                casters[i] = (unsigned int)cascade->casters[i];
+            }
+            stream_buffer_unmap(renderer->stream_buffer);
+        }
+    }
+    
+    return true;
+}
+
+// Redraw the cascades that changed into their layers of the shadow map, with
+// the depth-only program. Runs on the main context before any window is drawn.
+static void draw_shadow_maps(Renderer renderer) {
+    unsigned int stream = stream_buffer_get_buffer(renderer->stream_buffer);
+    
+    shader_use_program(renderer->shadow_program);
+    glActiveTexture(GL_TEXTURE0 + MODEL_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer->model_texture);
+    shader_set_int(renderer->shadow_program, "models", MODEL_TEXTURE_UNIT);
+    shader_set_int(renderer->shadow_program, "modelBase", (int)(renderer->model_offset / (4 * sizeof(float))));
+    
+    glBindVertexArray(renderer->windows[0].vao);
+    glBindBuffer(GL_ARRAY_BUFFER, stream);
+    
+    // Push stored depths back a little, more on slopes, against self-shadowing
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 2.0f);
+    
+    for (int v = 0; v < renderer->view_count; v++) {
+        RendererView* view = &renderer->views[v];
+        if (view->visible_count == 0) continue;
+        
+        for (int c = 0; c < RENDERER_SHADOW_CASCADES; c++) {
+            ShadowCascade* cascade = &view->cascades[c];
+            renderer->shadow_cascades_used++;
+            if (!cascade->draw) continue;
+            
+            render_target_bind(renderer->shadow_target, v * RENDERER_SHADOW_CASCADES + c);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            if (cascade->caster_count > 0) {
+                glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, stream,
+                                  (GLintptr)cascade->camera_offset, LIGHT_CAMERA_SIZE);
+                glVertexAttribIPointer(INSTANCE_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0, (void*)cascade->caster_offset);
+                cube_draw_instanced(renderer->cube, cascade->caster_count);
+                renderer->frame_draw_calls++;
+            }
+            cascade->valid = true;
+            renderer->shadow_cascades_drawn++;
+            metrics_counter_add(renderer->metrics.shadow_cascades_drawn, 1);
+        }
+    }
+    
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    render_target_unbind();
+}
+
+// Draw the texture footprint of every view into the feedback target, side
+// by side at a fraction of their size, then stream in what they need.
+// Runs on the main context before any window is drawn.
+static void update_virtual_texture(Renderer renderer) {
+    VirtualTexture texture = renderer->virtual_texture;
+    unsigned int stream = stream_buffer_get_buffer(renderer->stream_buffer);
+    
+    int sizes[RENDERER_MAX_VIEWS][2];
+    int width = 0, height = 0;
+    for (int v = 0; v < renderer->view_count; v++) {
+        const RendererView* view = &renderer->views[v];
+        sizes[v][0] = 0;
+        if (view->visible_count == 0 || !renderer->windows[view->config.window].window) continue;
+        
+        int rect[4];
+        get_view_rect(renderer, view, rect);
+        sizes[v][0] = rect[2] / RENDERER_FEEDBACK_DIVISOR > 1 ? rect[2] / RENDERER_FEEDBACK_DIVISOR : 1;
+        sizes[v][1] = rect[3] / RENDERER_FEEDBACK_DIVISOR > 1 ? rect[3] / RENDERER_FEEDBACK_DIVISOR : 1;
+        width += sizes[v][0];
+        height = sizes[v][1] > height ? sizes[v][1] : height;
+    }
+    
+    if (width > 0) {
+        virtual_texture_begin_feedback(texture, width, height);
+        
+        shader_use_program(renderer->feedback_program);
+        glActiveTexture(GL_TEXTURE0 + MODEL_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, renderer->model_texture);
+        shader_set_int(renderer->feedback_program, "models", MODEL_TEXTURE_UNIT);
+        shader_set_int(renderer->feedback_program, "modelBase", (int)(renderer->model_offset / (4 * sizeof(float))));
+        virtual_texture_bind(texture, renderer->feedback_program, PAGE_CACHE_TEXTURE_UNIT, PAGE_TABLE_TEXTURE_UNIT);
+        shader_set_float(renderer->feedback_program, "feedbackScale", log2f((float)RENDERER_FEEDBACK_DIVISOR));
+        
+        glBindVertexArray(renderer->windows[0].vao);
+        glBindBuffer(GL_ARRAY_BUFFER, stream);
+        
+        int x = 0;
+        for (int v = 0; v < renderer->view_count; v++) {
+            const RendererView* view = &renderer->views[v];
+            if (sizes[v][0] == 0) continue;
+            
+            glViewport(x, 0, sizes[v][0], sizes[v][1]);
+            glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, stream,
+                              (GLintptr)view->camera_offset, CAMERA_BLOCK_SIZE);
+            glVertexAttribIPointer(INSTANCE_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0, (void*)view->visible_offset);
+            cube_draw_instanced(renderer->cube, view->visible_count);
+            renderer->frame_draw_calls++;
+            x += sizes[v][0];
+        }
+        
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        virtual_texture_end_feedback(texture);
+    }
+    
+    virtual_texture_update(texture);
+}
+
+// Draw every view of one window; the window's context must be current
+static void draw_window(Renderer renderer, int window_index) {
+    RendererWindow* window = &renderer->windows[window_index];
+    unsigned int stream = stream_buffer_get_buffer(renderer->stream_buffer);
+    RenderTarget output = window_index == 0 ? renderer->replay_target : NULL; // NULL for the window
+    
+    // Offscreen targets keep the window's size, whatever part of them is
+    // used; a minimized window has nothing to draw into them
+    bool offscreen = window->scene_target && window->width > 0 && window->height > 0;
+    if (offscreen) {
+        offscreen = render_target_resize(window->scene_target, window->width, window->height) &&
+                    (!window->resolve_target ||
+                     render_target_resize(window->resolve_target, window->width, window->height));
+        if (offscreen) {
+            render_target_bind(window->scene_target, 0);
+        } else {
+            fprintf(stderr, "Drawing straight into the window instead\n");
+            release_window_targets(window);
+            window->render_width = window->width;
+            window->render_height = window->height;
+        }
+    }
+    if (!offscreen && output) {
+        render_target_bind(output, 0);
+    }
+    
+    // Set the clear color (background) and clear the whole window
+    glClearColor(
+        renderer->config.clear_color_r,
+        renderer->config.clear_color_g,
+        renderer->config.clear_color_b,
+        renderer->config.clear_color_a
+    );
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, window->render_width, window->render_height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST);
+    
+    // Use shader program with this frame's model matrices
+    shader_use_program(renderer->shader_program);
+    glActiveTexture(GL_TEXTURE0 + MODEL_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer->model_texture);
+    shader_set_int(renderer->shader_program, "models", MODEL_TEXTURE_UNIT);
+    shader_set_int(renderer->shader_program, "modelBase", (int)(renderer->model_offset / (4 * sizeof(float))));
+    shader_set_int(renderer->shader_program, "lightBase", (int)(renderer->light_offset / (4 * sizeof(float))));
+    
+    // And the lights, through each view's clusters
+    glActiveTexture(GL_TEXTURE0 + CLUSTER_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer->cluster_texture);
+    shader_set_int(renderer->shader_program, "clusters", CLUSTER_TEXTURE_UNIT);
+    
+    // And the key light's shadow map
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, render_target_get_depth_texture(renderer->shadow_target));
+    glActiveTexture(GL_TEXTURE0);
+    
+    // And the face labels
+    virtual_texture_bind(renderer->virtual_texture, renderer->shader_program,
+                         PAGE_CACHE_TEXTURE_UNIT, PAGE_TABLE_TEXTURE_UNIT);
+    
+    glBindVertexArray(window->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, stream);
+    
+    for (int v = 0; v < renderer->view_count; v++) {
+        RendererView* view = &renderer->views[v];
+        if (view->config.window != window_index) continue;
+        
+        // Views may overlap (picture-in-picture), so each clears its own rectangle
+        int rect[4];
+        get_view_rect(renderer, view, rect);
+        glViewport(rect[0], rect[1], rect[2], rect[3]);
+        glScissor(rect[0], rect[1], rect[2], rect[3]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        
+        if (view->visible_count == 0) continue;
+        
+        glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, stream,
+                          (GLintptr)view->camera_offset, CAMERA_BLOCK_SIZE);
+        glVertexAttribIPointer(INSTANCE_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0, (void*)view->visible_offset);
+        shader_set_int(renderer->shader_program, "clusterBase", (int)(view->cluster_offset / sizeof(unsigned int)));
+        cube_draw_instanced(renderer->cube, view->visible_count);
+        renderer->frame_draw_calls++;
+    }
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glDisable(GL_SCISSOR_TEST);
+    
+    // Resolve the samples at the render size, then scale up into the window
+    if (offscreen) {
+        int render_rect[4] = {0, 0, window->render_width, window->render_height};
+        int window_rect[4] = {0, 0, window->width, window->height};
+        RenderTarget source = window->scene_target;
+        if (window->resolve_target) {
+            render_target_blit(source, render_rect, window->resolve_target, render_rect, false);
+            source = window->resolve_target;
+        }
+        bool scaled = window->render_width != window->width || window->render_height != window->height;
+        render_target_blit(source, render_rect, output, window_rect, scaled);
+    }
+    
+    // Show a replay's output at whatever size the window really has
+    if (output) {
+        int output_rect[4] = {0, 0, window->width, window->height};
+        int window_rect[4] = {0, 0, 0, 0};
+        window_get_framebuffer_size(window->window, &window_rect[2], &window_rect[3]);
+        render_target_blit(output, output_rect, NULL, window_rect, true);
+    }
+    if (offscreen || output) {
+        render_target_unbind();
+        glViewport(0, 0, window->width, window->height);
+    }
+}
+
+// React to a key event, whether it comes from a window or a replay file
+static void apply_key(Renderer renderer, int key, int action, int mods) {
+    (void)mods;
+    
+    // Space pauses and resumes the animation
+    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
+        renderer->paused = !renderer->paused;
+    }
+}
+
+// Key events from the main window
+static void handle_key(void* user_data, int key, int action, int mods) {
+    Renderer renderer = (Renderer)user_data;
+    
+    // Keep the event for the next recorded frame
+    ReplayFrame* frame = &renderer->recorded_frame;
+    if (renderer->recorder && key >= 0 && frame->event_count < REPLAY_MAX_EVENTS_PER_FRAME) {
+        frame->events[frame->event_count].key = key;
+        frame->events[frame->event_count].action = action;
+        frame->events[frame->event_count].mods = mods;
+        frame->event_count++;
+    }
+    
+    apply_key(renderer, key, action, mods);
+}
+
+// Update the per-frame metrics once the frame has been submitted
+static void record_frame_metrics(Renderer renderer, double cpu_time) {
+    if (!renderer->metrics_registry) return;
+    
+    RendererMetrics* metrics = &renderer->metrics;
+    metrics_counter_add(metrics->frames, 1);
+    metrics_histogram_record(metrics->frame_cpu_time, cpu_time);
+    metrics_gauge_set(metrics->draw_calls, renderer->frame_draw_calls);
+    metrics_counter_add(metrics->draw_calls_total, (uint64_t)renderer->frame_draw_calls);
+    
+    int visible = 0;
+    for (int v = 0; v < renderer->view_count; v++) {
+        visible += renderer->views[v].visible_count;
+    }
+    metrics_gauge_set(metrics->visible_instances, visible);
+    
+    if (renderer->virtual_texture) {
+        int resident = 0, capacity = 0;
+        virtual_texture_get_residency(renderer->virtual_texture, &resident, &capacity);
+        metrics_gauge_set(metrics->texture_pages_resident, resident);
+    }
+    
+    // What the renderer allocated itself; the cube mesh is too small to count
+    size_t gl_memory = stream_buffer_get_size(renderer->stream_buffer) +
+                       render_target_get_memory_size(renderer->shadow_target) +
+                       virtual_texture_get_memory_size(renderer->virtual_texture);
+    for (int w = 0; w < renderer->window_count; w++) {
+        gl_memory += render_target_get_memory_size(renderer->windows[w].scene_target) +
+                     render_target_get_memory_size(renderer->windows[w].resolve_target);
+    }
+    gl_memory += render_target_get_memory_size(renderer->replay_target);
+    metrics_gauge_set(metrics->gl_memory, (double)gl_memory);
+    
+    double now = glfwGetTime();
+    if (renderer->free_memory_query && now >= renderer->next_memory_query) {
+        GLint free_kilobytes[4] = {0, 0, 0, 0};
+        glGetIntegerv(renderer->free_memory_query, free_kilobytes);
+        metrics_gauge_set(metrics->gl_memory_available, free_kilobytes[0] * 1024.0);
+        renderer->next_memory_query = now + RENDERER_METRICS_MEMORY_INTERVAL;
+    }
+}
+
+// Collect the GPU times of finished frames and, with dynamic resolution,
+// pick the scale that should bring the GPU time under the frame budget
+static void update_resolution_scale(Renderer renderer) {
+    double gpu_time = 0.0;
+    bool measured = false;
+    while (gpu_timer_get_result(renderer->gpu_timer, &gpu_time)) {
+        if (gpu_time > RENDERER_MAX_GPU_FRAME_TIME) continue;
+        metrics_histogram_record(renderer->metrics.frame_gpu_time, gpu_time);
+        renderer->gpu_time_average = renderer->gpu_time_average > 0.0 ?
+            renderer->gpu_time_average + RENDERER_RESOLUTION_SMOOTHING * (gpu_time - renderer->gpu_time_average) :
+            gpu_time;
+        measured = true;
+    }
+    if (!measured || !renderer->config.dynamic_resolution || renderer->resolution_fixed ||
+        renderer->gpu_time_average <= 0.0) return;
+    
+    // GPU time grows about with the number of pixels, the square of the
+    // scale; the results lag a few frames, so approach the scale in steps
+    double target_interval = renderer->config.target_frame_rate > 0 ?
+        1.0 / renderer->config.target_frame_rate : renderer->refresh_interval;
+    double budget = RENDERER_RESOLUTION_HEADROOM * target_interval;
+    double scale = renderer->resolution_scale;
+    double wanted = scale * sqrt(budget / renderer->gpu_time_average);
+    if (wanted > scale + RENDERER_RESOLUTION_MAX_STEP) wanted = scale + RENDERER_RESOLUTION_MAX_STEP;
+    if (wanted < scale - RENDERER_RESOLUTION_MAX_STEP) wanted = scale - RENDERER_RESOLUTION_MAX_STEP;
+    if (wanted > 1.0) wanted = 1.0;
+    if (wanted < renderer->config.min_resolution_scale) wanted = renderer->config.min_resolution_scale;
+    renderer->resolution_scale = (float)wanted;
+}
+
+// Render one frame that advances the animation by delta_time seconds
+static void render_frame(Renderer renderer, double delta_time) {
+    double start_time = glfwGetTime();
+    renderer->frame_draw_calls = 0;
+    
+    // Swap in a recompiled shader program at the frame boundary
+    if (shader_reloader_poll(renderer->shader_reloader, renderer->shader_reload_id, &renderer->shader_program)) {
+        setup_shader_program(renderer);
+    }
+    if (shader_reloader_poll(renderer->shader_reloader, renderer->feedback_reload_id, &renderer->feedback_program)) {
+        setup_feedback_program(renderer);
+    }
+    if (shader_reloader_poll(renderer->shader_reloader, renderer->shadow_reload_id, &renderer->shadow_program)) {
+        setup_shadow_program(renderer);
+    }
+    
+    // Advance the animation and propagate transforms through the dirty subtrees
+    if (!renderer->paused) {
+        renderer->animation_time += delta_time;
+    }
+    
+    // A paused scene keeps its pose; posing it again would mark every moving
+    // node dirty and redraw the shadow cascades they are in
+    if (renderer->animation_time != renderer->animated_time) {
+        animate_scene(renderer, (float)renderer->animation_time);
+        renderer->animated_time = renderer->animation_time;
+    }
+    scene_update(renderer->scene, renderer->thread_pool);
+    
+    // Get window sizes for viewports and aspect ratios
+    for (int w = 0; w < renderer->window_count; w++) {
+        RendererWindow* window = &renderer->windows[w];
+        window_get_framebuffer_size(window->window, &window->width, &window->height);
+    }
+    if (renderer->forced_width > 0) {
+        renderer->windows[0].width = renderer->forced_width;
+        renderer->windows[0].height = renderer->forced_height;
+    }
+    
+    // Draw offscreen windows at the current resolution scale
+    update_resolution_scale(renderer);
+    metrics_gauge_set(renderer->metrics.resolution_scale, renderer->resolution_scale);
+    for (int w = 0; w < renderer->window_count; w++) {
+        RendererWindow* window = &renderer->windows[w];
+        window->render_width = window->width;
+        window->render_height = window->height;
+        if (window->scene_target && window->width > 0 && window->height > 0) {
+            window->render_width = (int)((float)window->width * renderer->resolution_scale + 0.5f);
+            window->render_height = (int)((float)window->height * renderer->resolution_scale + 0.5f);
+            window->render_width = window->render_width > 1 ? window->render_width : 1;
+            window->render_height = window->render_height > 1 ? window->render_height : 1;
+        }
+    }
+    
+    if (!upload_frame_data(renderer)) {
+        fprintf(stderr, "Skipping frame: per-frame data does not fit the stream buffer\n");
+        stream_buffer_end_frame(renderer->stream_buffer);
+        metrics_counter_add(renderer->metrics.dropped_frames, 1);
+        return;
+    }
+    
+    // Time the GPU work of the frame on the main context
+    gpu_timer_begin(renderer->gpu_timer);
+    
+    // Redraw the shadow cascades that something moved in
+    if (renderer->shadow_target) {
+        draw_shadow_maps(renderer);
+    }
+    
+    // Stream in the texture pages this frame's views need
+    if (renderer->virtual_texture) {
+        update_virtual_texture(renderer);
+    }
+    
+    // Secondary windows draw first on their own contexts. Each waits for the
+    // uploads above and signals when done, so the main context's end-of-frame
+    // fence only passes once every window has finished reading this frame's data.
+    GLsync upload_fence = NULL;
+    GLsync window_fences[RENDERER_MAX_WINDOWS];
+    int window_fence_count = 0;
+    if (renderer->window_count > 1) {
+        upload_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        
+        for (int w = 1; w < renderer->window_count; w++) {
+            if (!renderer->windows[w].window) continue;
+            
+            window_make_context_current(renderer->windows[w].window);
+            glWaitSync(upload_fence, 0, GL_TIMEOUT_IGNORED);
+            draw_window(renderer, w);
+            window_fences[window_fence_count++] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+        }
+        
+        window_make_context_current(renderer->windows[0].window);
+        glDeleteSync(upload_fence);
+        for (int i = 0; i < window_fence_count; i++) {
+            glWaitSync(window_fences[i], 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(window_fences[i]);
+        }
+    }
+    
+    draw_window(renderer, 0);
+    gpu_timer_end(renderer->gpu_timer);
+    stream_buffer_end_frame(renderer->stream_buffer);
+    record_frame_metrics(renderer, glfwGetTime() - start_time);
+}
+
+// Swap every open window and process events
+static void present_frame(Renderer renderer) {
+    // Swap front and back buffers
+    for (int w = 0; w < renderer->window_count; w++) {
+        if (renderer->windows[w].window) {
+            window_swap_buffers(renderer->windows[w].window);
+        }
+    }
+    
+    // Poll for and process events
+    window_poll_events();
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Close a secondary window; its views stop being drawn
+static void close_window(Renderer renderer, int window_index) {
+    RendererWindow* window = &renderer->windows[window_index];
+    if (!window->window) return;
+    
+    window_make_context_current(window->window);
+    glDeleteVertexArrays(1, &window->vao);
+    release_window_targets(window);
+    window_destroy_shared(window->window);
+    window->window = NULL;
+    window_make_context_current(renderer->windows[0].window);
+}
+
+// Register the renderer's metrics and start exporting them
+static void setup_metrics(Renderer renderer) {
+    MetricsRegistry registry = metrics_registry_create();
+    if (!registry) return;
+    
+    RendererMetrics* metrics = &renderer->metrics;
+    metrics->frames = metrics_register_counter(registry, "cube_frames_total", "Frames rendered");
+    metrics->dropped_frames = metrics_register_counter(registry, "cube_dropped_frames_total",
+        "Display refreshes missed by late frames, plus frames skipped for lack of stream buffer space");
+    metrics->frame_time = metrics_register_histogram(registry, "cube_frame_time_seconds",
+        "Time from one frame to the next (CPU and GPU time of each frame during replays)",
+        RENDERER_METRICS_MIN_TIME, RENDERER_METRICS_MAX_TIME);
+    metrics->frame_cpu_time = metrics_register_histogram(registry, "cube_frame_cpu_seconds",
+        "CPU time spent preparing and submitting a frame", RENDERER_METRICS_MIN_TIME, RENDERER_METRICS_MAX_TIME);
+    if (renderer->gpu_timer) {
+        metrics->frame_gpu_time = metrics_register_histogram(registry, "cube_frame_gpu_seconds",
+            "GPU time of a frame's commands on the main window's context",
+            RENDERER_METRICS_MIN_TIME, RENDERER_METRICS_MAX_TIME);
+    }
+    if (renderer->windows[0].scene_target) {
+        metrics->resolution_scale = metrics_register_gauge(registry, "cube_resolution_scale",
+            "Fraction of the window size the views are drawn at");
+    }
+    metrics->draw_calls = metrics_register_gauge(registry, "cube_draw_calls", "Draw calls issued by the last frame");
+    metrics->draw_calls_total = metrics_register_counter(registry, "cube_draw_calls_total", "Draw calls issued");
+    metrics->visible_instances = metrics_register_gauge(registry, "cube_visible_instances",
+        "Cubes drawn by the last frame, summed over views");
+    metrics->gl_memory = metrics_register_gauge(registry, "cube_gl_memory_bytes",
+        "GPU memory allocated by the renderer for streaming, shadow maps, textures and offscreen targets");
+    if (renderer->shadow_program) {
+        metrics->shadow_cascades_drawn = metrics_register_counter(registry, "cube_shadow_cascades_drawn_total",
+            "Shadow cascades redrawn rather than kept from the previous frame");
+    }
+    if (renderer->virtual_texture) {
+        metrics->texture_pages_resident = metrics_register_gauge(registry, "cube_texture_pages_resident",
+            "Virtual texture pages in the page cache");
+    }
+    
+    // Not every driver says how much memory is left
+    if (glfwExtensionSupported("GL_NVX_gpu_memory_info")) {
+        renderer->free_memory_query = GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX;
+    } else if (glfwExtensionSupported("GL_ATI_meminfo")) {
+        renderer->free_memory_query = TEXTURE_FREE_MEMORY_ATI;
+    }
+    if (renderer->free_memory_query) {
+        metrics->gl_memory_available = metrics_register_gauge(registry, "cube_gl_memory_available_bytes",
+            "Free GPU memory reported by the driver");
+    }
+    
+    MetricsExporterConfig exporter_config = metrics_exporter_config_default();
+    exporter_config.port = renderer->config.metrics_port;
+    exporter_config.path = renderer->config.metrics_path;
+    renderer->metrics_exporter = metrics_exporter_create(registry, exporter_config);
+    if (!renderer->metrics_exporter) {
+        fprintf(stderr, "Metrics export unavailable\n");
+        metrics_registry_destroy(registry);
+        memset(metrics, 0, sizeof(*metrics));
+        renderer->free_memory_query = 0;
+        return;
+    }
+    renderer->metrics_registry = registry;
+}
 
 RendererConfig renderer_config_default(void) {
     RendererConfig config;
@@ -63,6 +1486,22 @@ RendererConfig renderer_config_default(void) {
     config.clear_color_b = 0.3f;
     config.clear_color_a = 1.0f;
     config.rotation_speed = 1.0f; // 1 radian per second
+    config.shader_directory = CUBE_SHADER_DIR;
+    config.hot_reload_shaders = true;
+    config.grid_size = 0;
+    config.occlusion_culling = true;
+    config.light_count = 1024;
+    config.texture_path = NULL;
+    config.texture_budget_mb = 32;
+    config.shadow_map_size = 1024;
+    config.cache_shadows = true;
+    config.metrics_port = 0;
+    config.metrics_path = NULL;
+    config.msaa_samples = 0;
+    config.resolution_scale = 1.0f;
+    config.dynamic_resolution = false;
+    config.min_resolution_scale = 0.5f;
+    config.target_frame_rate = 0;
     return config;
 }
 
@@ -77,11 +1516,25 @@ RendererWindowConfig renderer_window_config_default(void) {
     return config;
 }
 
-bool renderer_init_with_window(RendererConfig renderer_config, RendererWindowConfig window_config) {
-    // Store the renderer configuration
-    current_config = renderer_config;
-    
-    // Convert our WindowConfig to the window module's format
+RendererViewConfig renderer_view_config_default(void) {
+    RendererViewConfig config;
+    config.window = 0;
+    config.viewport_x = 0.0f;
+    config.viewport_y = 0.0f;
+    config.viewport_width = 1.0f;
+    config.viewport_height = 1.0f;
+    config.eye_x = 0.0f;
+    config.eye_y = 3.0f;
+    config.eye_z = 9.0f;
+    config.target_x = 0.0f;
+    config.target_y = 0.0f;
+    config.target_z = 0.0f;
+    config.fov_degrees = 45.0f;
+    return config;
+}
+
+// Convert our RendererWindowConfig to the window module's format
+static WindowConfig to_window_config(RendererWindowConfig window_config) {
     WindowConfig win_config;
     win_config.width = window_config.width;
     win_config.height = window_config.height;
@@ -89,117 +1542,579 @@ bool renderer_init_with_window(RendererConfig renderer_config, RendererWindowCon
     win_config.fullscreen = window_config.fullscreen;
     win_config.gl_major_version = window_config.gl_major_version;
     win_config.gl_minor_version = window_config.gl_minor_version;
+    return win_config;
+}
+
+Renderer renderer_init_with_window(RendererConfig renderer_config, RendererWindowConfig window_config) {
+    Renderer renderer = (Renderer)calloc(1, sizeof(struct RendererImpl));
+    if (!renderer) {
+        fprintf(stderr, "Failed to allocate renderer\n");
+        return NULL;
+    }
+    
+    // Store the renderer configuration
+    renderer->config = renderer_config;
+    
+    // Keep the resolution scales within what the renderer supports
+    float* scales[2] = {&renderer->config.resolution_scale, &renderer->config.min_resolution_scale};
+    for (int i = 0; i < 2; i++) {
+        if (!(*scales[i] >= RENDERER_MIN_RESOLUTION_SCALE)) *scales[i] = RENDERER_MIN_RESOLUTION_SCALE;
+        if (*scales[i] > 1.0f) *scales[i] = 1.0f;
+    }
+    renderer->resolution_scale = renderer->config.resolution_scale;
+    
+    // Likewise the shadow cascades, if there are any
+    if (renderer->config.shadow_map_size < 0) {
+        renderer->config.shadow_map_size = 0;
+    } else if (renderer->config.shadow_map_size > 0 && renderer->config.shadow_map_size < RENDERER_MIN_SHADOW_MAP_SIZE) {
+        renderer->config.shadow_map_size = RENDERER_MIN_SHADOW_MAP_SIZE;
+    }
     
     // Initialize window
-    window = window_init(win_config);
+    Window window = window_init(to_window_config(window_config));
     if (!window) {
-        return false;
+        free(renderer);
+        return NULL;
     }
-    
-    // Set up window callbacks
-    window_setup_callbacks(window);
+    renderer->windows[0].window = window;
+    renderer->window_count = 1;
     
     // Print OpenGL information
     window_print_gl_info();
     
-    // Create shader program
-    shader_program = shader_create_program(vertex_shader_source, fragment_shader_source);
+    // Input from the main window drives the renderer (and recordings)
+    window_set_key_handler(window, handle_key, renderer);
     
-    // Initialize time tracking
-    last_frame_time = glfwGetTime();
+    // Create shader program from the shader files
+    char vertex_shader_path[1024], fragment_shader_path[1024];
+    snprintf(vertex_shader_path, sizeof(vertex_shader_path), "%s/cube.vert", renderer->config.shader_directory);
+    snprintf(fragment_shader_path, sizeof(fragment_shader_path), "%s/cube.frag", renderer->config.shader_directory);
+    renderer->shader_program = shader_create_program_from_files(vertex_shader_path, fragment_shader_path);
+    if (!renderer->shader_program) {
+        fprintf(stderr, "Failed to create shader program\n");
+        renderer_terminate(renderer);
+        return NULL;
+    }
+    setup_shader_program(renderer);
     
-    // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
+    // Watch the shader files and recompile them in the background
+    renderer->shader_reload_id = -1;
+    renderer->feedback_reload_id = -1;
+    renderer->shadow_reload_id = -1;
+    if (renderer->config.hot_reload_shaders) {
+        renderer->shader_reloader = shader_reloader_create(window);
+        if (!renderer->shader_reloader) {
+            fprintf(stderr, "Shader hot reloading unavailable\n");
+        }
+        renderer->shader_reload_id = shader_reloader_add_program(renderer->shader_reloader, vertex_shader_path,
+                                                                 fragment_shader_path);
+    }
     
     // Create the cube
-    cube = cube_create();
-    if (!cube) {
+    renderer->cube = cube_create();
+    if (!renderer->cube || !setup_window_context(renderer, &renderer->windows[0])) {
         fprintf(stderr, "Failed to create cube\n");
-        return false;
+        renderer_terminate(renderer);
+        return NULL;
     }
     
-    return true;
+    // Create the worker threads
+    renderer->thread_pool = thread_pool_create(0);
+    
+    // Create the scene
+    if (!build_scene(renderer) || !build_lights(renderer)) {
+        fprintf(stderr, "Failed to create scene\n");
+        renderer_terminate(renderer);
+        return NULL;
+    }
+    
+    // Create the streaming buffer, large enough for a few frames of model
+    // matrices, lights, visibility and light lists but no larger than the
+    // integer buffer texture over it can address. A light typically lands
+    // in a few dozen clusters of each view, and an instance in a couple of
+    // the shadow cascades redrawn for each.
+    int max_texels = 0, uniform_alignment = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+    int instance_lists = renderer->config.shadow_map_size > 0 ? 3 * RENDERER_MAX_VIEWS : RENDERER_MAX_VIEWS;
+    size_t frame_size = (size_t)renderer->instance_count * (16 * sizeof(float) + instance_lists * sizeof(unsigned int)) +
+                        (size_t)renderer->light_count * (8 * sizeof(float) + RENDERER_MAX_VIEWS * 64 * sizeof(unsigned int)) +
+                        (size_t)RENDERER_MAX_VIEWS * CLUSTER_GRID_COUNT * 2 * sizeof(unsigned int);
+    size_t stream_size = RENDERER_STREAM_BUFFER_SIZE;
+    if (frame_size * RENDERER_STREAM_BUFFER_FRAMES > stream_size) {
+        stream_size = frame_size * RENDERER_STREAM_BUFFER_FRAMES;
+    }
+    if (max_texels > 0 && (size_t)max_texels * sizeof(unsigned int) < stream_size) {
+        stream_size = (size_t)max_texels * sizeof(unsigned int);
+    }
+    renderer->uniform_alignment = uniform_alignment > 0 ? (size_t)uniform_alignment : 256;
+    renderer->stream_buffer = stream_buffer_create(stream_size);
+    if (!renderer->stream_buffer) {
+        renderer_terminate(renderer);
+        return NULL;
+    }
+    
+    // Model matrices are fetched as RGBA32F texels straight from the stream
+    glGenTextures(1, &renderer->model_texture);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer->model_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, stream_buffer_get_buffer(renderer->stream_buffer));
+    glGenTextures(1, &renderer->cluster_texture);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer->cluster_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, stream_buffer_get_buffer(renderer->stream_buffer));
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    
+    // Stream the face labels from a tile file, if one was given
+    if (renderer->config.texture_path) {
+        char feedback_shader_path[1024];
+        snprintf(feedback_shader_path, sizeof(feedback_shader_path), "%s/feedback.frag", renderer->config.shader_directory);
+        renderer->virtual_texture = virtual_texture_create(renderer->config.texture_path,
+                                                           (size_t)renderer->config.texture_budget_mb * 1024 * 1024);
+        if (renderer->virtual_texture) {
+            renderer->feedback_program = shader_create_program_from_files(vertex_shader_path, feedback_shader_path);
+        }
+        if (!renderer->feedback_program) {
+            fprintf(stderr, "Failed to set up texture streaming\n");
+            renderer_terminate(renderer);
+            return NULL;
+        }
+        setup_shader_program(renderer);
+        setup_feedback_program(renderer);
+        
+        renderer->feedback_reload_id = shader_reloader_add_program(renderer->shader_reloader, vertex_shader_path,
+                                                                   feedback_shader_path);
+    }
+    
+    // Shadows of the key light, drawn with a depth-only program into a
+    // shadow map that is created with the views
+    if (renderer->config.shadow_map_size > 0) {
+        char shadow_vertex_path[1024], shadow_fragment_path[1024];
+        snprintf(shadow_vertex_path, sizeof(shadow_vertex_path), "%s/shadow.vert", renderer->config.shader_directory);
+        snprintf(shadow_fragment_path, sizeof(shadow_fragment_path), "%s/shadow.frag", renderer->config.shader_directory);
+        renderer->shadow_program = shader_create_program_from_files(shadow_vertex_path, shadow_fragment_path);
+        if (!renderer->shadow_program) {
+            fprintf(stderr, "Failed to create shadow shader program\n");
+            renderer_terminate(renderer);
+            return NULL;
+        }
+        setup_shadow_program(renderer);
+        
+        renderer->shadow_reload_id = shader_reloader_add_program(renderer->shader_reloader, shadow_vertex_path,
+                                                                 shadow_fragment_path);
+        
+        // The light never turns, so cascades only ever move within its view
+        matrix_look_at(renderer->light_view, 0.0f, 0.0f, 0.0f,
+                       -RENDERER_KEY_LIGHT_X, -RENDERER_KEY_LIGHT_Y, -RENDERER_KEY_LIGHT_Z,
+                       0.0f, 1.0f, 0.0f);
+    }
+    
+    // Start with one view covering the main window
+    if (renderer_add_view(renderer, renderer_view_config_default()) < 0) {
+        renderer_terminate(renderer);
+        return NULL;
+    }
+    
+    // Time the frames on the GPU for dynamic resolution and the metrics
+    bool export_metrics = renderer->config.metrics_port > 0 || renderer->config.metrics_path;
+    if (renderer->config.dynamic_resolution || export_metrics) {
+        renderer->gpu_timer = gpu_timer_create();
+    }
+    
+    // Export telemetry, if asked to
+    if (export_metrics) {
+        setup_metrics(renderer);
+    }
+    
+    // Initialize time tracking
+    int refresh_rate = window_get_refresh_rate();
+    renderer->refresh_interval = 1.0 / (refresh_rate > 0 ? refresh_rate : RENDERER_DEFAULT_REFRESH_RATE);
+    renderer->last_frame_time = glfwGetTime();
+    renderer->animated_time = -1.0;
+    
+    return renderer;
+}
+
+int renderer_add_window(Renderer renderer, RendererWindowConfig window_config) {
+    if (!renderer || renderer->window_count >= RENDERER_MAX_WINDOWS) return -1;
+    
+    int index = renderer->window_count;
+    RendererWindow* window = &renderer->windows[index];
+    window->window = window_create_shared(to_window_config(window_config), renderer->windows[0].window);
+    if (!window->window) {
+        window_make_context_current(renderer->windows[0].window);
+        return -1;
+    }
+    
+    // The new context is current; give it its own vertex array and state
+    if (!setup_window_context(renderer, window)) {
+        window_destroy_shared(window->window);
+        window->window = NULL;
+        window_make_context_current(renderer->windows[0].window);
+        return -1;
+    }
+    
+    window_make_context_current(renderer->windows[0].window);
+    renderer->window_count++;
+    return index;
 }
 
-void renderer_render_frame(void) {
+int renderer_add_view(Renderer renderer, RendererViewConfig view_config) {
+    if (!renderer || renderer->view_count >= RENDERER_MAX_VIEWS) return -1;
+    if (view_config.window < 0 || view_config.window >= renderer->window_count) return -1;
+    
+    RendererView* view = &renderer->views[renderer->view_count];
+    memset(view, 0, sizeof(*view));
+    view->visible = (int*)malloc((size_t)renderer->instance_capacity * sizeof(int));
+    view->clusters = cluster_grid_create(renderer->light_count);
+    if (renderer->config.occlusion_culling) {
+        view->occlusion = occlusion_buffer_create(RENDERER_OCCLUSION_WIDTH, RENDERER_OCCLUSION_HEIGHT);
+    }
+    bool casters_allocated = true;
+    if (renderer->config.shadow_map_size > 0) {
+        for (int c = 0; c < RENDERER_SHADOW_CASCADES; c++) {
+            view->cascades[c].casters = (int*)malloc((size_t)renderer->instance_capacity * sizeof(int));
+            casters_allocated = casters_allocated && view->cascades[c].casters;
+        }
+    }
+    if (!view->visible || !view->clusters || (renderer->config.occlusion_culling && !view->occlusion) ||
+        !casters_allocated) {
+        fprintf(stderr, "Failed to allocate view\n");
+        free(view->visible);
+        cluster_grid_destroy(view->clusters);
+        occlusion_buffer_destroy(view->occlusion);
+        for (int c = 0; c < RENDERER_SHADOW_CASCADES; c++) {
+            free(view->cascades[c].casters);
+        }
+        return -1;
+    }
+    
+    view->config = view_config;
+    return renderer->view_count++;
+}
+
+void renderer_set_view(Renderer renderer, int view, RendererViewConfig view_config) {
+    if (!renderer || view < 0 || view >= renderer->view_count) return;
+    if (view_config.window < 0 || view_config.window >= renderer->window_count) return;
+    
+    renderer->views[view].config = view_config;
+}
+
+void renderer_render_frame(Renderer renderer) {
+    if (!renderer) return;
+    
     // Calculate delta time
     double current_time = glfwGetTime();
-    double delta_time = current_time - last_frame_time;
-    last_frame_time = current_time;
+    double delta_time = current_time - renderer->last_frame_time;
+    renderer->last_frame_time = current_time;
     
-    // Clear the screen
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // With vsync, a frame that took longer than a refresh left the one
+    // before it on screen for every refresh it missed
+    if (renderer->metrics_registry) {
+        metrics_histogram_record(renderer->metrics.frame_time, delta_time);
+        int missed_refreshes = (int)(delta_time / renderer->refresh_interval + 0.5) - 1;
+        if (missed_refreshes > 0) {
+            metrics_counter_add(renderer->metrics.dropped_frames, (uint64_t)missed_refreshes);
+        }
+    }
     
-    // Set the clear color (background)
-    glClearColor(
-        current_config.clear_color_r,
-        current_config.clear_color_g,
-        current_config.clear_color_b,
-        current_config.clear_color_a
-    );
+    if (renderer->recorder) {
+        // Replays store the time step as a float; use the same value here so
+        // the recorded run and its replays animate identically
+        ReplayFrame* frame = &renderer->recorded_frame;
+        frame->delta_time = (float)delta_time;
+        delta_time = frame->delta_time;
+        window_get_framebuffer_size(renderer->windows[0].window, &frame->width, &frame->height);
+        
+        if (!replay_writer_write_frame(renderer->recorder, frame)) {
+            replay_writer_close(renderer->recorder);
+            renderer->recorder = NULL;
+        }
+        frame->event_count = 0;
+    }
+    
+    render_frame(renderer, delta_time);
+}
+
+bool renderer_start_recording(Renderer renderer, const char* path) {
+    if (!renderer) return false;
+    
+    replay_writer_close(renderer->recorder);
+    renderer->recorder = replay_writer_open(path);
+    renderer->recorded_frame.event_count = 0;
+    if (!renderer->recorder) return false;
+    
+    // Start from the state replays start from; the first recorded time step
+    // is measured from here
+    renderer->animation_time = 0.0;
+    renderer->paused = false;
+    renderer->last_frame_time = glfwGetTime();
+    return true;
+}
+
+bool renderer_run_replay(Renderer renderer, const char* replay_path, const char* timings_path, bool hash_frames) {
+    if (!renderer) return false;
     
-    // Use shader program
-    shader_use_program(shader_program);
+    ReplayReader reader = replay_reader_open(replay_path);
+    if (!reader) {
+        return false;
+    }
+    
+    FILE* timings = stdout;
+    if (timings_path) {
+        timings = fopen(timings_path, "w");
+        if (!timings) {
+            fprintf(stderr, "Failed to create timings file: %s\n", timings_path);
+            replay_reader_close(reader);
+            return false;
+        }
+    }
+    fprintf(timings, hash_frames ? "frame,delta_ms,frame_ms,hash\n" : "frame,delta_ms,frame_ms\n");
     
-    // Create view and projection matrices
-    float view[16], projection[16];
+    // Run as fast as possible, from the same state as the recording
+    Window main_window = renderer->windows[0].window;
+    window_set_swap_interval(main_window, 0);
+    renderer->animation_time = 0.0;
+    renderer->paused = false;
     
-    // View matrix - use look_at to position the camera
-    // Position the camera at (0, 0, 4) looking at the origin (0, 0, 0) with up vector (0, 1, 0)
-    matrix_look_at(view, 
-                  0.0f, 0.0f, 4.0f,   // Eye position
-                  0.0f, 0.0f, 0.0f,   // Look at point (center of the scene)
-                  0.0f, 1.0f, 0.0f);  // Up vector
+    // Hashes must not depend on how fast texture pages arrive or on the
+    // GPU times dynamic resolution follows
+    virtual_texture_set_synchronous(renderer->virtual_texture, hash_frames);
+    renderer->resolution_scale = renderer->config.resolution_scale;
+    renderer->resolution_fixed = hash_frames;
+    float min_scale = renderer->resolution_scale;
+    float max_scale = renderer->resolution_scale;
+    renderer->shadow_cascades_drawn = 0;
+    renderer->shadow_cascades_used = 0;
     
-    // Get window size for aspect ratio
-    int width, height;
-    GLFWwindow* glfw_window = window_get_glfw_window(window);
-    glfwGetFramebufferSize(glfw_window, &width, &height);
-    float aspect_ratio = (float)width / (float)height;
+    double* frame_times = NULL;
+    int frame_capacity = 0;
+    int frame_count = 0;
+    unsigned char* pixels = NULL;
+    size_t pixels_size = 0;
+    uint64_t run_hash = REPLAY_HASH_SEED;
+    ReplayFrame frame;
+    
+    bool replaying = true;
+    while (!window_should_close(main_window) && replay_reader_next_frame(reader, &frame)) {
+        // Reproduce the recorded framebuffer size offscreen
+        if (frame.width > 0 && (frame.width != renderer->forced_width || frame.height != renderer->forced_height)) {
+            if (renderer->replay_target) {
+                replaying = render_target_resize(renderer->replay_target, frame.width, frame.height);
+            } else {
+                RenderTargetConfig config = render_target_config_default();
+                config.width = frame.width;
+                config.height = frame.height;
+                renderer->replay_target = render_target_create(config);
+                replaying = renderer->replay_target != NULL;
+            }
+            if (!replaying) {
+                fprintf(stderr, "Failed to create a %dx%d target to replay into\n", frame.width, frame.height);
+                break;
+            }
+            renderer->forced_width = frame.width;
+            renderer->forced_height = frame.height;
+        }
+        
+        for (int i = 0; i < frame.event_count; i++) {
+            apply_key(renderer, frame.events[i].key, frame.events[i].action, frame.events[i].mods);
+        }
+        
+        // Time the frame including the GPU work it caused
+        double start_time = glfwGetTime();
+        render_frame(renderer, frame.delta_time);
+        glFinish();
+        double frame_ms = (glfwGetTime() - start_time) * 1000.0;
+        metrics_histogram_record(renderer->metrics.frame_time, frame_ms / 1000.0);
+        min_scale = renderer->resolution_scale < min_scale ? renderer->resolution_scale : min_scale;
+        max_scale = renderer->resolution_scale > max_scale ? renderer->resolution_scale : max_scale;
+        
+        if (frame_count == frame_capacity) {
+            frame_capacity = frame_capacity ? frame_capacity * 2 : 1024;
+            double* grown = (double*)realloc(frame_times, (size_t)frame_capacity * sizeof(double));
+            if (!grown) break;
+            frame_times = grown;
+        }
+        frame_times[frame_count] = frame_ms;
+        
+        fprintf(timings, "%d,%.3f,%.3f", frame_count, frame.delta_time * 1000.0, frame_ms);
+        if (hash_frames) {
+            // Hash what the main window drew at the recorded size; nothing
+            // was drawn before the recording saw the window's size
+            int width = 0, height = 0;
+            render_target_get_size(renderer->replay_target, &width, &height);
+            size_t size = (size_t)width * (size_t)height * 4;
+            if (size > pixels_size) {
+                unsigned char* grown = (unsigned char*)realloc(pixels, size);
+                if (grown) {
+                    pixels = grown;
+                    pixels_size = size;
+                }
+            }
+            
+            uint64_t frame_hash = REPLAY_HASH_SEED;
+            if (size > 0 && size <= pixels_size && render_target_read_pixels(renderer->replay_target, pixels)) {
+                frame_hash = replay_hash(frame_hash, pixels, size);
+            }
+            run_hash = replay_hash(run_hash, &frame_hash, sizeof(frame_hash));
+            fprintf(timings, ",%016llx", (unsigned long long)frame_hash);
+        }
+        fprintf(timings, "\n");
+        frame_count++;
+        
+        present_frame(renderer);
+    }
     
-    // Projection matrix - perspective projection
-    matrix_perspective(projection, 45.0f * (3.14159f / 180.0f), aspect_ratio, 0.1f, 100.0f);
+    // Summary for quick A/B comparisons
+    if (frame_count > 0) {
+        double total_ms = 0.0;
+        for (int i = 0; i < frame_count; i++) {
+            total_ms += frame_times[i];
+        }
+        qsort(frame_times, (size_t)frame_count, sizeof(double), compare_doubles);
+        printf("Replayed %d frames in %.1f ms: mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+               frame_count, total_ms, total_ms / frame_count,
+               frame_times[frame_count / 2],
+               frame_times[(int)(frame_count * 0.95)],
+               frame_times[(int)(frame_count * 0.99)],
+               frame_times[frame_count - 1]);
+        if (hash_frames) {
+            printf("Replay output hash: %016llx\n", (unsigned long long)run_hash);
+        }
+        if (renderer->virtual_texture) {
+            int resident = 0, capacity = 0;
+            virtual_texture_get_residency(renderer->virtual_texture, &resident, &capacity);
+            printf("Texture pages resident: %d of %d\n", resident, capacity);
+        }
+        if (renderer->shadow_cascades_used > 0) {
+            printf("Shadow cascades redrawn: %d of %d\n", renderer->shadow_cascades_drawn,
+                   renderer->shadow_cascades_used);
+        }
+        if (renderer->config.dynamic_resolution && !renderer->resolution_fixed) {
+            printf("Resolution scale: %.2f to %.2f\n", min_scale, max_scale);
+        }
+    }
     
-    // Set view and projection uniforms
-    shader_set_mat4(shader_program, "view", view);
-    shader_set_mat4(shader_program, "projection", projection);
+    // Back to live rendering
+    render_target_destroy(renderer->replay_target);
+    renderer->replay_target = NULL;
+    renderer->forced_width = 0;
+    renderer->forced_height = 0;
+    renderer->resolution_fixed = false;
+    window_set_swap_interval(main_window, 1);
+    renderer->last_frame_time = glfwGetTime(); // The replay's duration is not a frame
     
-    // Render the cube
-    cube_render(cube, shader_program, (float)delta_time, current_config.rotation_speed);
+    free(frame_times);
+    free(pixels);
+    if (timings != stdout) {
+        fclose(timings);
+    }
+    replay_reader_close(reader);
+    return replaying && frame_count > 0;
 }
 
-void renderer_run_main_loop(void) {
-    if (!window) {
+void renderer_run_main_loop(Renderer renderer) {
+    if (!renderer || !renderer->windows[0].window) {
         fprintf(stderr, "Cannot run main loop: window not initialized\n");
         return;
     }
     
     // Main loop
-    while (!window_should_close(window)) {
+    while (!window_should_close(renderer->windows[0].window)) {
         // Render a frame
-        renderer_render_frame();
+        renderer_render_frame(renderer);
         
-        // Swap front and back buffers
-        window_swap_buffers(window);
+        // Show it and handle input
+        present_frame(renderer);
         
-        // Poll for and process events
-        window_poll_events();
+        // Closing a secondary window only removes its views
+        for (int w = 1; w < renderer->window_count; w++) {
+            if (renderer->windows[w].window && window_should_close(renderer->windows[w].window)) {
+                close_window(renderer, w);
+            }
+        }
     }
 }
 
-void renderer_terminate(void) {
+void renderer_terminate(Renderer renderer) {
+    if (!renderer) return;
+    
+    // Secondary windows go first; the main window's context stays current
+    for (int w = 1; w < renderer->window_count; w++) {
+        close_window(renderer, w);
+    }
+    
+    for (int v = 0; v < renderer->view_count; v++) {
+        free(renderer->views[v].visible);
+        occlusion_buffer_destroy(renderer->views[v].occlusion);
+        cluster_grid_destroy(renderer->views[v].clusters);
+        for (int c = 0; c < RENDERER_SHADOW_CASCADES; c++) {
+            free(renderer->views[v].cascades[c].casters);
+        }
+    }
+    
+    // Finish the recording
+    replay_writer_close(renderer->recorder);
+    
+    // Stop exporting metrics, leaving the final values in the export file
+    metrics_exporter_destroy(renderer->metrics_exporter);
+    metrics_registry_destroy(renderer->metrics_registry);
+    
+    // Clean up scene
+    scene_destroy(renderer->scene);
+    free(renderer->instances);
+    free(renderer->instance_bounds);
+    free(renderer->previous_bounds);
+    free(renderer->changed_instances);
+    free(renderer->lights);
+    free(renderer->light_spheres);
+    
+    // Stop the worker threads
+    thread_pool_destroy(renderer->thread_pool);
+    
+    // Clean up per-frame upload resources
+    if (renderer->model_texture) {
+        glDeleteTextures(1, &renderer->model_texture);
+    }
+    if (renderer->cluster_texture) {
+        glDeleteTextures(1, &renderer->cluster_texture);
+    }
+    stream_buffer_destroy(renderer->stream_buffer);
+    
+    // Stop streaming textures
+    virtual_texture_destroy(renderer->virtual_texture);
+    
+    // Clean up the shadow map
+    render_target_destroy(renderer->shadow_target);
+    
+    // Clean up the main window's offscreen drawing and timing
+    release_window_targets(&renderer->windows[0]);
+    gpu_timer_destroy(renderer->gpu_timer);
+    
     // Clean up cube
-    if (cube) {
-        cube_destroy(cube);
-        cube = NULL;
+    if (renderer->windows[0].vao) {
+        glDeleteVertexArrays(1, &renderer->windows[0].vao);
+    }
+    if (renderer->cube) {
+        cube_destroy(renderer->cube);
     }
     
-    // Clean up shader
-    shader_delete_program(shader_program);
+    // Stop watching before the window and its shared context go away
+    shader_reloader_destroy(renderer->shader_reloader);
+    
+    // Clean up shaders
+    if (renderer->shader_program) {
+        shader_delete_program(renderer->shader_program);
+    }
+    if (renderer->feedback_program) {
+        shader_delete_program(renderer->feedback_program);
+    }
+    if (renderer->shadow_program) {
+        shader_delete_program(renderer->shadow_program);
+    }
     
     // Clean up window
-    if (window) {
-        window_terminate(window);
-        window = NULL;
+    if (renderer->windows[0].window) {
+        window_terminate(renderer->windows[0].window);
     }
-} 
\ No newline at end of file
+    
+    free(renderer);
+}
@@ -4,6 +4,10 @@
 #include <stdbool.h>
 #include "../utils/objects/cube.h"
 
+// Opaque handle for a renderer
+// A renderer owns one scene and the GL objects shared by all of its windows
+typedef struct RendererImpl* Renderer;
+
 // Renderer configuration structure
 typedef struct {
     float clear_color_r;
@@ -11,6 +15,22 @@ typedef struct {
     float clear_color_b;
     float clear_color_a;
     float rotation_speed; // Rotation speed in radians per second
+    const char* shader_directory; // Directory containing cube.vert and cube.frag
+    bool hot_reload_shaders; // Recompile shaders in the background when the files change
+    int grid_size; // Cubes per side of a static block behind the scene (0 for none)
+    bool occlusion_culling; // Skip cubes hidden behind the ones drawn last frame
+    int light_count; // Number of animated point lights
+    const char* texture_path; // Tile file of face labels to stream in (NULL for untextured cubes)
+    int texture_budget_mb; // GPU memory for resident texture pages, in megabytes
+    int shadow_map_size; // Texels per side of each shadow cascade, at least 16 (0 for no shadows)
+    bool cache_shadows; // Keep cascades that nothing moved in from the previous frame
+    int metrics_port; // Serve Prometheus metrics on this localhost port (0 for none)
+    const char* metrics_path; // File rewritten with the metrics every second (NULL for none)
+    int msaa_samples; // Samples per pixel of an offscreen scene target (0 or 1 for none)
+    float resolution_scale; // Fraction of the window size the views are drawn at (up to 1)
+    bool dynamic_resolution; // Adjust the scale to the GPU time to hold the target frame rate
+    float min_resolution_scale; // Lowest scale dynamic resolution may pick
+    int target_frame_rate; // Frame rate dynamic resolution aims for (0 for the monitor's)
 } RendererConfig;
 
 // Window configuration structure
@@ -23,22 +43,64 @@ typedef struct {
     int gl_minor_version;
 } RendererWindowConfig;
 
+// View configuration structure
+// A view is a camera drawn into a rectangle of one of the renderer's windows
+typedef struct {
+    int window; // Index returned by renderer_add_window (0 is the main window)
+    float viewport_x; // Viewport rectangle as fractions of the window, origin bottom-left
+    float viewport_y;
+    float viewport_width;
+    float viewport_height;
+    float eye_x; // Camera position
+    float eye_y;
+    float eye_z;
+    float target_x; // Point the camera looks at
+    float target_y;
+    float target_z;
+    float fov_degrees; // Vertical field of view
+} RendererViewConfig;
+
 // Default renderer configuration
 RendererConfig renderer_config_default(void);
 
 // Default window configuration
 RendererWindowConfig renderer_window_config_default(void);
 
-// Initialize the renderer with window
-bool renderer_init_with_window(RendererConfig renderer_config, RendererWindowConfig window_config);
+// Default view configuration (full main window)
+RendererViewConfig renderer_view_config_default(void);
+
+// Initialize the renderer with its main window and a default view of it
+// Returns NULL on failure
+Renderer renderer_init_with_window(RendererConfig renderer_config, RendererWindowConfig window_config);
+
+// Open another window sharing the renderer's GL objects
+// Returns the window index, or -1 on failure. The window starts without views.
+int renderer_add_window(Renderer renderer, RendererWindowConfig window_config);
+
+// Add a view to one of the renderer's windows
+// Returns the view index, or -1 on failure
+int renderer_add_view(Renderer renderer, RendererViewConfig view_config);
+
+// Replace the configuration of an existing view
+void renderer_set_view(Renderer renderer, int view, RendererViewConfig view_config);
+
+// Render a single frame into every window
+void renderer_render_frame(Renderer renderer);
+
+// Record the time step, framebuffer size and input of every following frame
+// The animation restarts from the beginning, unpaused, as replays do.
+bool renderer_start_recording(Renderer renderer, const char* path);
 
-// Render a single frame
-void renderer_render_frame(void);
+// Re-run a recording as fast as possible with the recorded time steps,
+// writing per-frame timings as CSV (to stdout if timings_path is NULL) and a
+// summary. With hash_frames, each frame's pixels are hashed so output can be
+// compared between runs. Returns false if the replay could not be read.
+bool renderer_run_replay(Renderer renderer, const char* replay_path, const char* timings_path, bool hash_frames);
 
-// Run the main render loop
-void renderer_run_main_loop(void);
+// Run the main render loop until the main window is closed
+void renderer_run_main_loop(Renderer renderer);
 
 // Clean up renderer and window resources
-void renderer_terminate(void);
+void renderer_terminate(Renderer renderer);
 
-#endif /* RENDERER_H */ 
\ No newline at end of file
+#endif /* RENDERER_H */
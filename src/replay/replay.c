@@ -0,0 +1,226 @@
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// File identification
+#define REPLAY_MAGIC "CUBR"
+#define REPLAY_VERSION 1
+
+// Frame flags
+#define REPLAY_FRAME_RESIZED 0x01
+#define REPLAY_FRAME_EVENTS 0x02
+#define REPLAY_FRAME_END 0xFF
+
+// Define the actual writer implementation structure
+struct ReplayWriterImpl {
+    FILE* file;
+    int width;  // Last size written, so unchanged sizes cost nothing
+    int height;
+};
+
+// Define the actual reader implementation structure
+struct ReplayReaderImpl {
+    FILE* file;
+    int width;
+    int height;
+};
+
+// Explicit little-endian encoding keeps files portable between machines
+
+static bool write_u8(FILE* file, unsigned int value) {
+    unsigned char byte = (unsigned char)value;
+    return fwrite(&byte, 1, 1, file) == 1;
+}
+
+static bool write_u16(FILE* file, unsigned int value) {
+    unsigned char bytes[2] = { (unsigned char)(value & 0xFF), (unsigned char)((value >> 8) & 0xFF) };
+    return fwrite(bytes, 1, 2, file) == 2;
+}
+
+static bool write_f32(FILE* file, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (unsigned char)((bits >> (8 * i)) & 0xFF);
+    }
+    return fwrite(bytes, 1, 4, file) == 4;
+}
+
+static bool read_u8(FILE* file, unsigned int* value) {
+    unsigned char byte;
+    if (fread(&byte, 1, 1, file) != 1) return false;
+    *value = byte;
+    return true;
+}
+
+static bool read_u16(FILE* file, unsigned int* value) {
+    unsigned char bytes[2];
+    if (fread(bytes, 1, 2, file) != 2) return false;
+    *value = (unsigned int)bytes[0] | ((unsigned int)bytes[1] << 8);
+    return true;
+}
+
+static bool read_f32(FILE* file, float* value) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, 4, file) != 4) return false;
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; i++) {
+        bits |= (uint32_t)bytes[i] << (8 * i);
+    }
+    memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+
+ReplayWriter replay_writer_open(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to create replay file: %s\n", path);
+        return NULL;
+    }
+    
+    ReplayWriter writer = (ReplayWriter)calloc(1, sizeof(struct ReplayWriterImpl));
+    if (!writer) {
+        fprintf(stderr, "Failed to allocate replay writer\n");
+        fclose(file);
+        return NULL;
+    }
+    writer->file = file;
+    
+    if (fwrite(REPLAY_MAGIC, 1, 4, file) != 4 || !write_u16(file, REPLAY_VERSION) || !write_u16(file, 0)) {
+        fprintf(stderr, "Failed to write replay header\n");
+        fclose(file);
+        free(writer);
+        return NULL;
+    }
+    
+    return writer;
+}
+
+bool replay_writer_write_frame(ReplayWriter writer, const ReplayFrame* frame) {
+    if (!writer) return false;
+    
+    bool resized = frame->width != writer->width || frame->height != writer->height;
+    int event_count = frame->event_count;
+    if (event_count > REPLAY_MAX_EVENTS_PER_FRAME) event_count = REPLAY_MAX_EVENTS_PER_FRAME;
+    
+    unsigned int flags = 0;
+    if (resized) flags |= REPLAY_FRAME_RESIZED;
+    if (event_count > 0) flags |= REPLAY_FRAME_EVENTS;
+    
+    bool ok = write_u8(writer->file, flags) && write_f32(writer->file, frame->delta_time);
+    if (ok && resized) {
+        ok = write_u16(writer->file, (unsigned int)frame->width) && write_u16(writer->file, (unsigned int)frame->height);
+        writer->width = frame->width;
+        writer->height = frame->height;
+    }
+    if (ok && event_count > 0) {
+        ok = write_u8(writer->file, (unsigned int)event_count);
+        for (int i = 0; ok && i < event_count; i++) {
+            const ReplayEvent* event = &frame->events[i];
+            ok = write_u16(writer->file, (unsigned int)event->key) &&
+                 write_u8(writer->file, (unsigned int)event->action) &&
+                 write_u8(writer->file, (unsigned int)event->mods);
+        }
+    }
+    
+    if (!ok) {
+        fprintf(stderr, "Failed to write replay frame\n");
+    }
+    return ok;
+}
+
+void replay_writer_close(ReplayWriter writer) {
+    if (!writer) return;
+    
+    write_u8(writer->file, REPLAY_FRAME_END);
+    fclose(writer->file);
+    free(writer);
+}
+
+ReplayReader replay_reader_open(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open replay file: %s\n", path);
+        return NULL;
+    }
+    
+    char magic[4];
+    unsigned int version, reserved;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, REPLAY_MAGIC, 4) != 0 ||
+        !read_u16(file, &version) || !read_u16(file, &reserved)) {
+        fprintf(stderr, "Not a replay file: %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+    if (version != REPLAY_VERSION) {
+        fprintf(stderr, "Unsupported replay version %u in %s\n", version, path);
+        fclose(file);
+        return NULL;
+    }
+    
+    ReplayReader reader = (ReplayReader)calloc(1, sizeof(struct ReplayReaderImpl));
+    if (!reader) {
+        fprintf(stderr, "Failed to allocate replay reader\n");
+        fclose(file);
+        return NULL;
+    }
+    reader->file = file;
+    
+    return reader;
+}
+
+bool replay_reader_next_frame(ReplayReader reader, ReplayFrame* frame) {
+    if (!reader) return false;
+    
+    unsigned int flags;
+    if (!read_u8(reader->file, &flags) || flags == REPLAY_FRAME_END) {
+        return false;
+    }
+    
+    bool ok = read_f32(reader->file, &frame->delta_time);
+    if (ok && (flags & REPLAY_FRAME_RESIZED)) {
+        unsigned int width, height;
+        ok = read_u16(reader->file, &width) && read_u16(reader->file, &height);
+        reader->width = (int)width;
+        reader->height = (int)height;
+    }
+    frame->width = reader->width;
+    frame->height = reader->height;
+    
+    frame->event_count = 0;
+    if (ok && (flags & REPLAY_FRAME_EVENTS)) {
+        unsigned int count;
+        ok = read_u8(reader->file, &count);
+        for (unsigned int i = 0; ok && i < count; i++) {
+            unsigned int key, action, mods;
+            ok = read_u16(reader->file, &key) && read_u8(reader->file, &action) && read_u8(reader->file, &mods);
+            frame->events[i].key = (int)key;
+            frame->events[i].action = (int)action;
+            frame->events[i].mods = (int)mods;
+        }
+        frame->event_count = ok ? (int)count : 0;
+    }
+    
+    if (!ok) {
+        fprintf(stderr, "Replay file is truncated\n");
+    }
+    return ok;
+}
+
+void replay_reader_close(ReplayReader reader) {
+    if (!reader) return;
+    
+    fclose(reader->file);
+    free(reader);
+}
+
+uint64_t replay_hash(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
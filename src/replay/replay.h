@@ -0,0 +1,65 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Replay files hold everything that drives a frame: the time step, the
+// framebuffer size and the input events since the previous frame.
+//
+// Layout (little-endian):
+//   header: "CUBR", u16 version, u16 reserved
+//   frame:  u8 flags, f32 delta_time,
+//           [u16 width, u16 height]        if flags bit 0 (size changed)
+//           [u8 count, count * event]       if flags bit 1 (input events)
+//   event:  u16 key, u8 action, u8 mods
+// A flags byte of 0xFF terminates the stream.
+
+// Most input events stored for one frame; extra events are dropped
+#define REPLAY_MAX_EVENTS_PER_FRAME 255
+
+// Input event captured from a window
+typedef struct {
+    int key;
+    int action;
+    int mods;
+} ReplayEvent;
+
+// Inputs of a single frame
+typedef struct {
+    float delta_time; // Seconds since the previous frame
+    int width;        // Framebuffer size of the main window
+    int height;
+    int event_count;
+    ReplayEvent events[REPLAY_MAX_EVENTS_PER_FRAME];
+} ReplayFrame;
+
+// Opaque handles for replay files being written and read
+typedef struct ReplayWriterImpl* ReplayWriter;
+typedef struct ReplayReaderImpl* ReplayReader;
+
+// Create a replay file for writing
+ReplayWriter replay_writer_open(const char* path);
+
+// Append a frame to the replay file
+bool replay_writer_write_frame(ReplayWriter writer, const ReplayFrame* frame);
+
+// Terminate the stream and close the file
+void replay_writer_close(ReplayWriter writer);
+
+// Open a replay file for reading
+ReplayReader replay_reader_open(const char* path);
+
+// Read the next frame; returns false at the end of the stream or on error
+bool replay_reader_next_frame(ReplayReader reader, ReplayFrame* frame);
+
+// Close the replay file
+void replay_reader_close(ReplayReader reader);
+
+// Fold a block of bytes into a running 64-bit FNV-1a hash
+// Start with REPLAY_HASH_SEED
+#define REPLAY_HASH_SEED 0xcbf29ce484222325ull
+uint64_t replay_hash(uint64_t hash, const void* data, size_t size);
+
+#endif /* REPLAY_H */
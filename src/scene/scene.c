@@ -0,0 +1,273 @@
+#include "scene.h"
+#include "../utils/math/math.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Smallest slice of a level handed to one thread
+#define SCENE_UPDATE_BATCH_SIZE 256
+
+// Define the actual scene implementation structure
+// Node data lives in "slots" kept sorted by depth, so every level of the
+// hierarchy is one contiguous range and a parent always precedes its
+// children. Handles stay stable and map to slots through slot_of_node.
+struct SceneImpl {
+    int capacity;
+    int count;
+    
+    // Per-slot data
+    float* local;              // 16 floats per slot
+    float* world;              // 16 floats per slot
+    int* parent_slot;          // -1 for root nodes
+    int* depth;
+    SceneNode* node_of_slot;
+    unsigned char* dirty;      // Local transform changed since the last update
+    unsigned char* changed;    // World transform recomputed in the last update
+    
+    // Per-handle data
+    int* slot_of_node;
+    
+    // Level l occupies slots [level_start[l], level_start[l + 1])
+    int* level_start;
+    int level_count;
+    bool topology_changed;
+    
+    int dirty_count;
+    bool any_changed;
+    
+    // Scratch space for re-sorting the slots
+    void* scratch;
+    int* new_slot;
+};
+
+// Shared state for the per-level parallel pass
+typedef struct {
+    Scene scene;
+    int offset;
+    atomic_int updated;
+} LevelJob;
+
+// Reorder count elements of the given size so that element i moves to new_slot[i]
+static void permute(void* data, size_t element_size, int count, const int* new_slot, void* scratch) {
+    char* src = (char*)data;
+    char* dst = (char*)scratch;
+    for (int i = 0; i < count; i++) {
+        memcpy(dst + (size_t)new_slot[i] * element_size, src + (size_t)i * element_size, element_size);
+    }
+    memcpy(data, scratch, (size_t)count * element_size);
+}
+
+// Stable counting sort of the slots by depth, then rebuild the level ranges
+static void sort_levels(Scene scene) {
+    int count = scene->count;
+    int max_depth = 0;
+    for (int i = 0; i < count; i++) {
+        if (scene->depth[i] > max_depth) max_depth = scene->depth[i];
+    }
+    scene->level_count = count > 0 ? max_depth + 1 : 0;
+    
+    // Level sizes, then prefix sums
+    memset(scene->level_start, 0, (size_t)(scene->level_count + 1) * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        scene->level_start[scene->depth[i] + 1]++;
+    }
+    for (int l = 0; l < scene->level_count; l++) {
+        scene->level_start[l + 1] += scene->level_start[l];
+    }
+    
+    // Destination slot of each current slot; the order within a level is kept
+    int* cursor = (int*)scene->scratch;
+    memcpy(cursor, scene->level_start, (size_t)scene->level_count * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        scene->new_slot[i] = cursor[scene->depth[i]]++;
+    }
+    
+    // Parents must be remapped before they are moved
+    for (int i = 0; i < count; i++) {
+        if (scene->parent_slot[i] >= 0) {
+            scene->parent_slot[i] = scene->new_slot[scene->parent_slot[i]];
+        }
+    }
+    
+    permute(scene->local, 16 * sizeof(float), count, scene->new_slot, scene->scratch);
+    permute(scene->world, 16 * sizeof(float), count, scene->new_slot, scene->scratch);
+    permute(scene->parent_slot, sizeof(int), count, scene->new_slot, scene->scratch);
+    permute(scene->depth, sizeof(int), count, scene->new_slot, scene->scratch);
+    permute(scene->node_of_slot, sizeof(SceneNode), count, scene->new_slot, scene->scratch);
+    permute(scene->dirty, 1, count, scene->new_slot, scene->scratch);
+    permute(scene->changed, 1, count, scene->new_slot, scene->scratch);
+    
+    for (int i = 0; i < count; i++) {
+        scene->slot_of_node[scene->node_of_slot[i]] = i;
+    }
+    
+    scene->topology_changed = false;
+}
+
+// Update a range of slots within one level
+// Parents live in earlier levels, which are complete by the time this runs
+static void update_level(void* context, int begin, int end) {
+    LevelJob* job = (LevelJob*)context;
+    Scene scene = job->scene;
+    int updated = 0;
+    
+    for (int slot = job->offset + begin; slot < job->offset + end; slot++) {
+        int parent = scene->parent_slot[slot];
+        if (!scene->dirty[slot] && (parent < 0 || !scene->changed[parent])) {
+            scene->changed[slot] = 0;
+            continue;
+        }
+        
+        float* world = scene->world + (size_t)slot * 16;
+        float* local = scene->local + (size_t)slot * 16;
+        if (parent < 0) {
+            memcpy(world, local, 16 * sizeof(float));
+        } else {
+            // matrix_multiply(r, a, b) yields b * a for our column-major
+            // matrices, so this is world = parent_world * local
+            matrix_multiply(world, local, scene->world + (size_t)parent * 16);
+        }
+        
+        scene->dirty[slot] = 0;
+        scene->changed[slot] = 1;
+        updated++;
+    }
+    
+    if (updated > 0) {
+        atomic_fetch_add(&job->updated, updated);
+    }
+}
+
+Scene scene_create(int capacity) {
+    if (capacity <= 0) return NULL;
+    
+    Scene scene = (Scene)calloc(1, sizeof(struct SceneImpl));
+    if (!scene) {
+        fprintf(stderr, "Failed to allocate scene\n");
+        return NULL;
+    }
+    
+    size_t n = (size_t)capacity;
+    scene->capacity = capacity;
+    scene->local = (float*)malloc(n * 16 * sizeof(float));
+    scene->world = (float*)malloc(n * 16 * sizeof(float));
+    scene->parent_slot = (int*)malloc(n * sizeof(int));
+    scene->depth = (int*)malloc(n * sizeof(int));
+    scene->node_of_slot = (SceneNode*)malloc(n * sizeof(SceneNode));
+    scene->dirty = (unsigned char*)calloc(n, 1);
+    scene->changed = (unsigned char*)calloc(n, 1);
+    scene->slot_of_node = (int*)malloc(n * sizeof(int));
+    scene->level_start = (int*)malloc((n + 1) * sizeof(int));
+    scene->scratch = malloc(n * 16 * sizeof(float));
+    scene->new_slot = (int*)malloc(n * sizeof(int));
+    
+    if (!scene->local || !scene->world || !scene->parent_slot || !scene->depth ||
+        !scene->node_of_slot || !scene->dirty || !scene->changed || !scene->slot_of_node ||
+        !scene->level_start || !scene->scratch || !scene->new_slot) {
+        fprintf(stderr, "Failed to allocate scene\n");
+        scene_destroy(scene);
+        return NULL;
+    }
+    
+    return scene;
+}
+
+SceneNode scene_add_node(Scene scene, SceneNode parent, const float* local_transform) {
+    if (!scene || scene->count >= scene->capacity) return SCENE_NODE_NONE;
+    if (parent != SCENE_NODE_NONE && (parent < 0 || parent >= scene->count)) return SCENE_NODE_NONE;
+    
+    // New nodes are appended; sort_levels moves them into their level later
+    SceneNode node = scene->count;
+    int slot = scene->count++;
+    int parent_slot = parent == SCENE_NODE_NONE ? -1 : scene->slot_of_node[parent];
+    
+    memcpy(scene->local + (size_t)slot * 16, local_transform, 16 * sizeof(float));
+    memcpy(scene->world + (size_t)slot * 16, local_transform, 16 * sizeof(float));
+    scene->parent_slot[slot] = parent_slot;
+    scene->depth[slot] = parent_slot < 0 ? 0 : scene->depth[parent_slot] + 1;
+    scene->node_of_slot[slot] = node;
+    scene->dirty[slot] = 1;
+    scene->changed[slot] = 0;
+    scene->slot_of_node[node] = slot;
+    
+    scene->dirty_count++;
+    scene->topology_changed = true;
+    return node;
+}
+
+void scene_set_local_transform(Scene scene, SceneNode node, const float* local_transform) {
+    if (!scene || node < 0 || node >= scene->count) return;
+    
+    int slot = scene->slot_of_node[node];
+    memcpy(scene->local + (size_t)slot * 16, local_transform, 16 * sizeof(float));
+    if (!scene->dirty[slot]) {
+        scene->dirty[slot] = 1;
+        scene->dirty_count++;
+    }
+}
+
+int scene_update(Scene scene, ThreadPool pool) {
+    if (!scene) return 0;
+    
+    if (scene->topology_changed) {
+        sort_levels(scene);
+    }
+    
+    // Nothing moved: only last update's change flags need clearing
+    if (scene->dirty_count == 0) {
+        if (scene->any_changed) {
+            memset(scene->changed, 0, (size_t)scene->count);
+            scene->any_changed = false;
+        }
+        return 0;
+    }
+    
+    LevelJob job;
+    job.scene = scene;
+    atomic_init(&job.updated, 0);
+    
+    // Levels run one after another; the nodes within a level are independent
+    for (int l = 0; l < scene->level_count; l++) {
+        job.offset = scene->level_start[l];
+        int level_size = scene->level_start[l + 1] - job.offset;
+        thread_pool_parallel_for(pool, level_size, SCENE_UPDATE_BATCH_SIZE, update_level, &job);
+    }
+    
+    int updated = atomic_load(&job.updated);
+    scene->dirty_count = 0;
+    scene->any_changed = updated > 0;
+    return updated;
+}
+
+const float* scene_get_world_transform(Scene scene, SceneNode node) {
+    if (!scene || node < 0 || node >= scene->count) return NULL;
+    return scene->world + (size_t)scene->slot_of_node[node] * 16;
+}
+
+bool scene_node_changed(Scene scene, SceneNode node) {
+    if (!scene || node < 0 || node >= scene->count) return false;
+    return scene->changed[scene->slot_of_node[node]] != 0;
+}
+
+int scene_get_node_count(Scene scene) {
+    if (!scene) return 0;
+    return scene->count;
+}
+
+void scene_destroy(Scene scene) {
+    if (!scene) return;
+    
+    free(scene->local);
+    free(scene->world);
+    free(scene->parent_slot);
+    free(scene->depth);
+    free(scene->node_of_slot);
+    free(scene->dirty);
+    free(scene->changed);
+    free(scene->slot_of_node);
+    free(scene->level_start);
+    free(scene->scratch);
+    free(scene->new_slot);
+    free(scene);
+}
@@ -0,0 +1,43 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdbool.h>
+#include "../utils/thread/thread_pool.h"
+
+// Opaque handle for a transform hierarchy
+typedef struct SceneImpl* Scene;
+
+// Node handle, stable for the lifetime of the scene
+typedef int SceneNode;
+
+// Parent value for nodes at the root of the hierarchy
+#define SCENE_NODE_NONE (-1)
+
+// Create an empty scene able to hold up to capacity nodes
+Scene scene_create(int capacity);
+
+// Add a node under parent (or SCENE_NODE_NONE) with the given local transform
+// Returns SCENE_NODE_NONE if the scene is full or the parent is invalid
+SceneNode scene_add_node(Scene scene, SceneNode parent, const float* local_transform);
+
+// Replace a node's local transform and mark its subtree dirty
+void scene_set_local_transform(Scene scene, SceneNode node, const float* local_transform);
+
+// Recompute world transforms of the dirty subtrees
+// Each depth level is processed in parallel on the pool (which may be NULL).
+// Returns the number of nodes whose world transform was recomputed.
+int scene_update(Scene scene, ThreadPool pool);
+
+// Get a node's world transform as of the last scene_update
+const float* scene_get_world_transform(Scene scene, SceneNode node);
+
+// Whether a node's world transform changed in the last scene_update
+bool scene_node_changed(Scene scene, SceneNode node);
+
+// Get the number of nodes in the scene
+int scene_get_node_count(Scene scene);
+
+// Destroy the scene and free resources
+void scene_destroy(Scene scene);
+
+#endif /* SCENE_H */
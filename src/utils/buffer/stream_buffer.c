@@ -0,0 +1,154 @@
+#include "stream_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Include OpenGL headers
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <glad/glad.h>
+#endif
+
+// Frames that may be in flight at once before the CPU has to wait
+#define STREAM_BUFFER_MAX_FRAMES 8
+
+// Data written by one frame, freed once its fence signals
+typedef struct {
+    GLsync fence;
+    size_t bytes;
+} FrameRecord;
+
+// Define the actual streaming buffer implementation structure
+struct StreamBufferImpl {
+    unsigned int buffer;
+    size_t size;
+    
+    size_t head;          // Next byte to hand out
+    size_t in_flight;     // Bytes owned by submitted frames
+    size_t frame_bytes;   // Bytes used by the current frame, padding included
+    
+    FrameRecord frames[STREAM_BUFFER_MAX_FRAMES];
+    int first_frame;
+    int frame_count;
+};
+
+// Release the oldest submitted frame, optionally waiting for the GPU first
+// Returns false if the frame is still in use and we were not allowed to wait
+static bool retire_oldest_frame(StreamBuffer buffer, bool wait) {
+    FrameRecord* frame = &buffer->frames[buffer->first_frame];
+    GLuint64 timeout = wait ? 1000000000ull : 0;
+    
+    for (;;) {
+        GLenum status = glClientWaitSync(frame->fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) break;
+        if (status == GL_WAIT_FAILED) {
+            fprintf(stderr, "Stream buffer fence wait failed\n");
+            break;
+        }
+        if (!wait) return false;
+    }
+    
+    glDeleteSync(frame->fence);
+    buffer->in_flight -= frame->bytes;
+    buffer->first_frame = (buffer->first_frame + 1) % STREAM_BUFFER_MAX_FRAMES;
+    buffer->frame_count--;
+    return true;
+}
+
+StreamBuffer stream_buffer_create(size_t size) {
+    StreamBuffer buffer = (StreamBuffer)calloc(1, sizeof(struct StreamBufferImpl));
+    if (!buffer) {
+        fprintf(stderr, "Failed to allocate stream buffer\n");
+        return NULL;
+    }
+    
+    buffer->size = size;
+    glGenBuffers(1, &buffer->buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    
+    return buffer;
+}
+
+void* stream_buffer_map(StreamBuffer buffer, size_t size, size_t alignment, size_t* offset) {
+    if (!buffer || size == 0 || size > buffer->size) return NULL;
+    if (alignment == 0) alignment = 1;
+    
+    // Recycle whatever the GPU has already finished with
+    while (buffer->frame_count > 0 && retire_oldest_frame(buffer, false)) {
+    }
+    
+    size_t start = (buffer->head + alignment - 1) / alignment * alignment;
+    size_t padding = start - buffer->head;
+    if (start + size > buffer->size) {
+        // Skip the tail of the buffer and wrap around
+        padding = buffer->size - buffer->head;
+        start = 0;
+    }
+    
+    // Space is freed in the order it was handed out, so keeping the total in
+    // use below the buffer size guarantees we never overwrite live data
+    size_t needed = padding + size;
+    while (buffer->in_flight + buffer->frame_bytes + needed > buffer->size) {
+        if (buffer->frame_count == 0) {
+            fprintf(stderr, "Stream buffer too small for this frame\n");
+            return NULL;
+        }
+        retire_oldest_frame(buffer, true);
+    }
+    
+    buffer->frame_bytes += needed;
+    buffer->head = start + size;
+    *offset = start;
+    
+    // Synchronization is ours, so the driver does not need to do any
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->buffer);
+    return glMapBufferRange(GL_COPY_WRITE_BUFFER, (GLintptr)start, (GLsizeiptr)size,
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void stream_buffer_unmap(StreamBuffer buffer) {
+    if (!buffer) return;
+    
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void stream_buffer_end_frame(StreamBuffer buffer) {
+    if (!buffer || buffer->frame_bytes == 0) return;
+    
+    if (buffer->frame_count == STREAM_BUFFER_MAX_FRAMES) {
+        retire_oldest_frame(buffer, true);
+    }
+    
+    int index = (buffer->first_frame + buffer->frame_count) % STREAM_BUFFER_MAX_FRAMES;
+    buffer->frames[index].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    buffer->frames[index].bytes = buffer->frame_bytes;
+    buffer->frame_count++;
+    
+    buffer->in_flight += buffer->frame_bytes;
+    buffer->frame_bytes = 0;
+}
+
+unsigned int stream_buffer_get_buffer(StreamBuffer buffer) {
+    if (!buffer) return 0;
+    return buffer->buffer;
+}
+
+size_t stream_buffer_get_size(StreamBuffer buffer) {
+    if (!buffer) return 0;
+    return buffer->size;
+}
+
+void stream_buffer_destroy(StreamBuffer buffer) {
+    if (!buffer) return;
+    
+    while (buffer->frame_count > 0) {
+        retire_oldest_frame(buffer, true);
+    }
+    
+    glDeleteBuffers(1, &buffer->buffer);
+    free(buffer);
+}
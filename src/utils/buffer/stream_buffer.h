@@ -0,0 +1,35 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Opaque handle for a streaming buffer
+// A ring buffer for per-frame data: every frame appends what it needs and
+// space is only reused once the GPU has finished the frames that read it
+typedef struct StreamBufferImpl* StreamBuffer;
+
+// Create a streaming buffer of the given size in bytes
+StreamBuffer stream_buffer_create(size_t size);
+
+// Map size bytes for writing, starting at a multiple of alignment
+// The write offset within the buffer is stored in *offset. Returns NULL if
+// the request can never fit. Blocks only if the GPU is frames behind.
+void* stream_buffer_map(StreamBuffer buffer, size_t size, size_t alignment, size_t* offset);
+
+// Finish writing the range returned by the last stream_buffer_map
+void stream_buffer_unmap(StreamBuffer buffer);
+
+// Mark the end of a frame; its data is recycled once the GPU is done with it
+void stream_buffer_end_frame(StreamBuffer buffer);
+
+// Get the GL buffer object
+unsigned int stream_buffer_get_buffer(StreamBuffer buffer);
+
+// Get the size of the buffer in bytes
+size_t stream_buffer_get_size(StreamBuffer buffer);
+
+// Destroy the streaming buffer
+void stream_buffer_destroy(StreamBuffer buffer);
+
+#endif /* STREAM_BUFFER_H */
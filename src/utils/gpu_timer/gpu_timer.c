@@ -0,0 +1,74 @@
+#include "gpu_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <glad/glad.h>
+#endif
+
+// Spans that may be in flight at once; the GPU is rarely more than a couple
+// of frames behind
+#define GPU_TIMER_QUERIES 4
+
+// Define the actual GPU timer implementation structure
+struct GpuTimerImpl {
+    unsigned int queries[GPU_TIMER_QUERIES];
+    int first_pending; // Oldest query waiting for its result
+    int pending_count;
+    bool measuring; // Between a begin that got a query and its end
+};
+
+GpuTimer gpu_timer_create(void) {
+    GpuTimer timer = (GpuTimer)calloc(1, sizeof(struct GpuTimerImpl));
+    if (!timer) {
+        fprintf(stderr, "Failed to allocate GPU timer\n");
+        return NULL;
+    }
+    
+    glGenQueries(GPU_TIMER_QUERIES, timer->queries);
+    return timer;
+}
+
+void gpu_timer_begin(GpuTimer timer) {
+    if (!timer || timer->measuring || timer->pending_count == GPU_TIMER_QUERIES) return;
+    
+    int index = (timer->first_pending + timer->pending_count) % GPU_TIMER_QUERIES;
+    glBeginQuery(GL_TIME_ELAPSED, timer->queries[index]);
+    timer->measuring = true;
+}
+
+void gpu_timer_end(GpuTimer timer) {
+    if (!timer || !timer->measuring) return;
+    
+    glEndQuery(GL_TIME_ELAPSED);
+    timer->measuring = false;
+    timer->pending_count++;
+}
+
+bool gpu_timer_get_result(GpuTimer timer, double* seconds) {
+    if (!timer || timer->pending_count == 0) return false;
+    
+    unsigned int query = timer->queries[timer->first_pending];
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+    
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    timer->first_pending = (timer->first_pending + 1) % GPU_TIMER_QUERIES;
+    timer->pending_count--;
+    *seconds = (double)nanoseconds * 1e-9;
+    return true;
+}
+
+void gpu_timer_destroy(GpuTimer timer) {
+    if (!timer) return;
+    
+    if (timer->measuring) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    glDeleteQueries(GPU_TIMER_QUERIES, timer->queries);
+    free(timer);
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <stdbool.h>
+
+// Opaque handle for a GPU timer
+// Measures the GPU time of a span of commands with GL_TIME_ELAPSED queries.
+// Results arrive a few frames late and are collected without waiting; while
+// every query is still in flight, new spans are not measured. Query objects
+// are not shared between GL contexts, so a timer is tied to the context that
+// created it.
+typedef struct GpuTimerImpl* GpuTimer;
+
+// Create a timer on the current GL context
+GpuTimer gpu_timer_create(void);
+
+// Start measuring the commands that follow
+void gpu_timer_begin(GpuTimer timer);
+
+// Stop measuring; spans must not overlap
+void gpu_timer_end(GpuTimer timer);
+
+// Get the oldest measurement the GPU has finished, in seconds
+// Returns false, without waiting, if none is ready.
+bool gpu_timer_get_result(GpuTimer timer, double* seconds);
+
+// Destroy the timer on the context that created it
+void gpu_timer_destroy(GpuTimer timer);
+
+#endif /* GPU_TIMER_H */
\ No newline at end of file
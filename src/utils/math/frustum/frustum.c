@@ -0,0 +1,36 @@
+#include "frustum.h"
+#include <math.h>
+
+void frustum_extract(Frustum* frustum, const float* m) {
+    // Matrices are column-major, so row i is m[i], m[4 + i], m[8 + i], m[12 + i]
+    for (int i = 0; i < 3; i++) {
+        for (int c = 0; c < 4; c++) {
+            float row_w = m[c * 4 + 3];
+            float row_i = m[c * 4 + i];
+            frustum->planes[i * 2][c] = row_w + row_i;
+            frustum->planes[i * 2 + 1][c] = row_w - row_i;
+        }
+    }
+    
+    // Normalize so plane distances are in world units
+    for (int p = 0; p < 6; p++) {
+        float* plane = frustum->planes[p];
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f) {
+            plane[0] /= length;
+            plane[1] /= length;
+            plane[2] /= length;
+            plane[3] /= length;
+        }
+    }
+}
+
+bool frustum_contains_sphere(const Frustum* frustum, float x, float y, float z, float radius) {
+    for (int p = 0; p < 6; p++) {
+        const float* plane = frustum->planes[p];
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,18 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <stdbool.h>
+
+// View frustum as six planes (a, b, c, d) with normals pointing inwards
+// Order: left, right, bottom, top, near, far
+typedef struct {
+    float planes[6][4];
+} Frustum;
+
+// Extract the frustum planes from a combined projection * view matrix
+void frustum_extract(Frustum* frustum, const float* view_projection);
+
+// Check whether a sphere is at least partially inside the frustum
+bool frustum_contains_sphere(const Frustum* frustum, float x, float y, float z, float radius);
+
+#endif /* FRUSTUM_H */
@@ -3,6 +3,7 @@
 
 // Include all math-related headers
 #include "matrix/matrix.h"
+#include "frustum/frustum.h"
 
 // Add any additional math-related declarations here
 
@@ -27,6 +27,19 @@ void matrix_perspective(float* matrix, float fov, float aspect, float near, floa
     matrix[14] = (2.0f * far * near) / (near - far);
 }
 
+void matrix_orthographic(float* matrix, float left, float right, float bottom, float top, float near, float far) {
+    // Initialize to zero
+    memset(matrix, 0, 16 * sizeof(float));
+    
+    matrix[0] = 2.0f / (right - left);
+    matrix[5] = 2.0f / (top - bottom);
+    matrix[10] = -2.0f / (far - near);
+    matrix[12] = -(right + left) / (right - left);
+    matrix[13] = -(top + bottom) / (top - bottom);
+    matrix[14] = -(far + near) / (far - near);
+    matrix[15] = 1.0f;
+}
+
 void matrix_rotate_x(float* matrix, float angle) {
     // Initialize to identity
     matrix_identity(matrix);
@@ -75,6 +88,15 @@ void matrix_translate(float* matrix, float x, float y, float z) {
     matrix[14] = z;
 }
 
+void matrix_scale(float* matrix, float x, float y, float z) {
+    // Initialize to identity
+    matrix_identity(matrix);
+    
+    matrix[0] = x;
+    matrix[5] = y;
+    matrix[10] = z;
+}
+
 void matrix_look_at(float* matrix, 
                    float eye_x, float eye_y, float eye_z,
                    float center_x, float center_y, float center_z,
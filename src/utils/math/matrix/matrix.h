@@ -7,6 +7,9 @@ void matrix_identity(float* matrix);
 // Create a 4x4 perspective projection matrix
 void matrix_perspective(float* matrix, float fov, float aspect, float near, float far);
 
+// Create a 4x4 orthographic projection matrix
+void matrix_orthographic(float* matrix, float left, float right, float bottom, float top, float near, float far);
+
 // Create a 4x4 rotation matrix around the X axis
 void matrix_rotate_x(float* matrix, float angle);
 
@@ -19,6 +22,9 @@ void matrix_rotate_z(float* matrix, float angle);
 // Create a 4x4 translation matrix
 void matrix_translate(float* matrix, float x, float y, float z);
 
+// Create a 4x4 scaling matrix
+void matrix_scale(float* matrix, float x, float y, float z);
+
 // Create a 4x4 look-at view matrix
 void matrix_look_at(float* matrix, 
                    float eye_x, float eye_y, float eye_z,
@@ -0,0 +1,325 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Most metrics one registry holds
+#define METRICS_MAX_METRICS 64
+
+// Histogram buckets: values below 2^METRICS_SUB_BUCKET_BITS units get a
+// bucket each, and every power of two above is split into half that many
+// buckets, so a bucket is never wider than 1/128 of the values in it
+#define METRICS_SUB_BUCKET_BITS 8
+#define METRICS_HALF_BUCKETS (1 << (METRICS_SUB_BUCKET_BITS - 1))
+
+// Exported histogram buckets per power of two (must divide 8)
+#define METRICS_EXPORT_STEPS 4
+
+typedef enum {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+} MetricKind;
+
+// Define the actual metric implementation structure
+struct MetricImpl {
+    MetricKind kind;
+    char* name;
+    char* help;
+    
+    // Counter value, or the bits of a gauge's double
+    atomic_uint_least64_t value;
+    
+    // Histograms count values in units of lowest, up to highest_units
+    double lowest;
+    uint64_t highest_units;
+    int bucket_count;
+    atomic_uint_least64_t* buckets;
+    atomic_uint_least64_t sum_bits; // Double sum of the recorded values
+};
+
+// Define the actual registry implementation structure
+struct MetricsRegistryImpl {
+    // Registration is serialized; readers only look at the published count
+    pthread_mutex_t lock;
+    Metric metrics[METRICS_MAX_METRICS];
+    atomic_int count;
+};
+
+static uint64_t double_to_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bits_to_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Index of the highest set bit of a non-zero value
+static int highest_bit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+#endif
+}
+
+static int bucket_index(uint64_t units) {
+    if (units < 2 * METRICS_HALF_BUCKETS) return (int)units;
+    
+    int shift = highest_bit(units) - METRICS_SUB_BUCKET_BITS + 1;
+    return shift * METRICS_HALF_BUCKETS + (int)(units >> shift);
+}
+
+// Smallest value, in units, that lands in a bucket
+static uint64_t bucket_lower_bound(int index) {
+    if (index < 2 * METRICS_HALF_BUCKETS) return (uint64_t)index;
+    
+    int shift = index / METRICS_HALF_BUCKETS - 1;
+    return (uint64_t)(index - shift * METRICS_HALF_BUCKETS) << shift;
+}
+
+// Prometheus metric names: [a-zA-Z_:][a-zA-Z0-9_:]*
+static bool valid_name(const char* name) {
+    if (!name || !*name || (*name >= '0' && *name <= '9')) return false;
+    for (const char* c = name; *c; c++) {
+        bool letter = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z');
+        bool digit = *c >= '0' && *c <= '9';
+        if (!letter && !digit && *c != '_' && *c != ':') return false;
+    }
+    return true;
+}
+
+static char* copy_string(const char* str) {
+    size_t length = strlen(str);
+    char* copy = (char*)malloc(length + 1);
+    if (copy) {
+        memcpy(copy, str, length + 1);
+    }
+    return copy;
+}
+
+static void destroy_metric(Metric metric) {
+    if (!metric) return;
+    
+    free(metric->name);
+    free(metric->help);
+    free(metric->buckets);
+    free(metric);
+}
+
+// Add a metric to the registry, taking ownership of it
+static Metric publish(MetricsRegistry registry, Metric metric) {
+    pthread_mutex_lock(&registry->lock);
+    int count = atomic_load_explicit(&registry->count, memory_order_relaxed);
+    bool duplicate = false;
+    for (int i = 0; i < count; i++) {
+        duplicate = duplicate || strcmp(registry->metrics[i]->name, metric->name) == 0;
+    }
+    if (duplicate || count == METRICS_MAX_METRICS) {
+        pthread_mutex_unlock(&registry->lock);
+        fprintf(stderr, duplicate ? "Metric %s is already registered\n" : "Too many metrics to register %s\n",
+                metric->name);
+        destroy_metric(metric);
+        return NULL;
+    }
+    
+    // Exports only read metrics below the count, once they are complete
+    registry->metrics[count] = metric;
+    atomic_store_explicit(&registry->count, count + 1, memory_order_release);
+    pthread_mutex_unlock(&registry->lock);
+    return metric;
+}
+
+static Metric create_metric(MetricsRegistry registry, MetricKind kind, const char* name, const char* help) {
+    if (!registry) return NULL;
+    if (!valid_name(name)) {
+        fprintf(stderr, "Invalid metric name: %s\n", name ? name : "(null)");
+        return NULL;
+    }
+    
+    Metric metric = (Metric)calloc(1, sizeof(struct MetricImpl));
+    if (!metric) {
+        fprintf(stderr, "Failed to allocate metric %s\n", name);
+        return NULL;
+    }
+    metric->kind = kind;
+    metric->name = copy_string(name);
+    metric->help = copy_string(help ? help : "");
+    if (!metric->name || !metric->help) {
+        fprintf(stderr, "Failed to allocate metric %s\n", name);
+        destroy_metric(metric);
+        return NULL;
+    }
+    atomic_init(&metric->value, kind == METRIC_GAUGE ? double_to_bits(0.0) : 0);
+    atomic_init(&metric->sum_bits, double_to_bits(0.0));
+    return metric;
+}
+
+MetricsRegistry metrics_registry_create(void) {
+    MetricsRegistry registry = (MetricsRegistry)calloc(1, sizeof(struct MetricsRegistryImpl));
+    if (!registry) {
+        fprintf(stderr, "Failed to allocate metrics registry\n");
+        return NULL;
+    }
+    pthread_mutex_init(&registry->lock, NULL);
+    atomic_init(&registry->count, 0);
+    return registry;
+}
+
+Metric metrics_register_counter(MetricsRegistry registry, const char* name, const char* help) {
+    Metric metric = create_metric(registry, METRIC_COUNTER, name, help);
+    return metric ? publish(registry, metric) : NULL;
+}
+
+Metric metrics_register_gauge(MetricsRegistry registry, const char* name, const char* help) {
+    Metric metric = create_metric(registry, METRIC_GAUGE, name, help);
+    return metric ? publish(registry, metric) : NULL;
+}
+
+Metric metrics_register_histogram(MetricsRegistry registry, const char* name, const char* help,
+                                  double lowest, double highest) {
+    if (!(lowest > 0.0) || !(highest > lowest) || highest / lowest > (double)(UINT64_C(1) << 62)) {
+        fprintf(stderr, "Invalid range for histogram %s\n", name ? name : "(null)");
+        return NULL;
+    }
+    
+    Metric metric = create_metric(registry, METRIC_HISTOGRAM, name, help);
+    if (!metric) return NULL;
+    
+    metric->lowest = lowest;
+    metric->highest_units = (uint64_t)(highest / lowest);
+    metric->bucket_count = bucket_index(metric->highest_units) + 1;
+    metric->buckets = (atomic_uint_least64_t*)malloc((size_t)metric->bucket_count * sizeof(atomic_uint_least64_t));
+    if (!metric->buckets) {
+        fprintf(stderr, "Failed to allocate histogram %s\n", name);
+        destroy_metric(metric);
+        return NULL;
+    }
+    for (int i = 0; i < metric->bucket_count; i++) {
+        atomic_init(&metric->buckets[i], 0);
+    }
+    return publish(registry, metric);
+}
+
+void metrics_counter_add(Metric counter, uint64_t amount) {
+    if (!counter) return;
+    
+    atomic_fetch_add_explicit(&counter->value, amount, memory_order_relaxed);
+}
+
+void metrics_gauge_set(Metric gauge, double value) {
+    if (!gauge) return;
+    
+    atomic_store_explicit(&gauge->value, double_to_bits(value), memory_order_relaxed);
+}
+
+void metrics_histogram_record(Metric histogram, double value) {
+    if (!histogram) return;
+    
+    double scaled = value / histogram->lowest;
+    uint64_t units = 0;
+    if (scaled >= (double)histogram->highest_units) {
+        units = histogram->highest_units;
+    } else if (scaled > 0.0) {
+        units = (uint64_t)scaled;
+    }
+    atomic_fetch_add_explicit(&histogram->buckets[bucket_index(units)], 1, memory_order_relaxed);
+    
+    uint64_t old_bits = atomic_load_explicit(&histogram->sum_bits, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&histogram->sum_bits, &old_bits,
+                                                  double_to_bits(bits_to_double(old_bits) + value),
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Write help text with backslashes and line breaks escaped
+static void write_help(FILE* out, const Metric metric) {
+    fprintf(out, "# HELP %s ", metric->name);
+    for (const char* c = metric->help; *c; c++) {
+        if (*c == '\\') {
+            fputs("\\\\", out);
+        } else if (*c == '\n') {
+            fputs("\\n", out);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('\n', out);
+}
+
+// Write a histogram's cumulative counts at METRICS_EXPORT_STEPS bucket
+// boundaries per power of two. Every boundary is also one of ours, so the
+// counts are exact; the total is the sum of the buckets read, which keeps
+// the output consistent while other threads record values.
+static void write_histogram(FILE* out, const Metric metric) {
+    uint64_t cumulative = 0;
+    int bucket = 0;
+    for (int edge_index = 0; ; edge_index++) {
+        // Evenly spaced from 8 up to 16 units, scaled by successive powers of two
+        int power = edge_index / METRICS_EXPORT_STEPS;
+        int step = edge_index % METRICS_EXPORT_STEPS;
+        uint64_t edge = (uint64_t)(8 + step * (8 / METRICS_EXPORT_STEPS)) << power;
+        if (edge > metric->highest_units) break;
+        
+        while (bucket < metric->bucket_count && bucket_lower_bound(bucket) < edge) {
+            cumulative += atomic_load_explicit(&metric->buckets[bucket], memory_order_relaxed);
+            bucket++;
+        }
+        fprintf(out, "%s_bucket{le=\"%.6g\"} %llu\n", metric->name, (double)edge * metric->lowest,
+                (unsigned long long)cumulative);
+    }
+    while (bucket < metric->bucket_count) {
+        cumulative += atomic_load_explicit(&metric->buckets[bucket], memory_order_relaxed);
+        bucket++;
+    }
+    
+    double sum = bits_to_double(atomic_load_explicit(&metric->sum_bits, memory_order_relaxed));
+    fprintf(out, "%s_bucket{le=\"+Inf\"} %llu\n", metric->name, (unsigned long long)cumulative);
+    fprintf(out, "%s_sum %.15g\n", metric->name, sum);
+    fprintf(out, "%s_count %llu\n", metric->name, (unsigned long long)cumulative);
+}
+
+bool metrics_write_text(MetricsRegistry registry, FILE* out) {
+    if (!registry || !out) return false;
+    
+    int count = atomic_load_explicit(&registry->count, memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        const Metric metric = registry->metrics[i];
+        write_help(out, metric);
+        
+        uint64_t value = atomic_load_explicit(&metric->value, memory_order_relaxed);
+        switch (metric->kind) {
+            case METRIC_COUNTER:
+                fprintf(out, "# TYPE %s counter\n%s %llu\n", metric->name, metric->name, (unsigned long long)value);
+                break;
+            case METRIC_GAUGE:
+                fprintf(out, "# TYPE %s gauge\n%s %.15g\n", metric->name, metric->name, bits_to_double(value));
+                break;
+            case METRIC_HISTOGRAM:
+                fprintf(out, "# TYPE %s histogram\n", metric->name);
+                write_histogram(out, metric);
+                break;
+        }
+    }
+    return !ferror(out);
+}
+
+void metrics_registry_destroy(MetricsRegistry registry) {
+    if (!registry) return;
+    
+    int count = atomic_load(&registry->count);
+    for (int i = 0; i < count; i++) {
+        destroy_metric(registry->metrics[i]);
+    }
+    pthread_mutex_destroy(&registry->lock);
+    free(registry);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Opaque handle for a metrics registry
+// A fixed set of named metrics, registered once at startup and then updated
+// from any thread without locks. Updates are relaxed atomic operations, so
+// an export may see one metric a few updates ahead of another.
+typedef struct MetricsRegistryImpl* MetricsRegistry;
+
+// Opaque handle for one metric of a registry
+// Updating a NULL metric does nothing, so callers may keep NULL handles when
+// metrics are turned off.
+typedef struct MetricImpl* Metric;
+
+// Create an empty registry
+MetricsRegistry metrics_registry_create(void);
+
+// Register a counter, a gauge or a histogram
+// Names follow Prometheus conventions (e.g. cube_frames_total) and must be
+// unique. Returns NULL if the registry is full or NULL.
+Metric metrics_register_counter(MetricsRegistry registry, const char* name, const char* help);
+Metric metrics_register_gauge(MetricsRegistry registry, const char* name, const char* help);
+
+// Histograms keep values from lowest to highest in log-linear buckets with
+// better than 1% precision, like HDR histograms; values outside the range
+// are clamped to it
+Metric metrics_register_histogram(MetricsRegistry registry, const char* name, const char* help,
+                                  double lowest, double highest);
+
+// Add to a counter
+void metrics_counter_add(Metric counter, uint64_t amount);
+
+// Set a gauge
+void metrics_gauge_set(Metric gauge, double value);
+
+// Record a value in a histogram
+void metrics_histogram_record(Metric histogram, double value);
+
+// Write every metric in the Prometheus text exposition format
+// Histograms are written with a few buckets per power of two.
+bool metrics_write_text(MetricsRegistry registry, FILE* out);
+
+// Destroy the registry and its metrics; nothing may update them any more
+void metrics_registry_destroy(MetricsRegistry registry);
+
+#endif /* METRICS_H */
\ No newline at end of file
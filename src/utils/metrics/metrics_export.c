@@ -0,0 +1,304 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "metrics_export.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// How long the exporter blocks before re-checking whether it should stop
+#define METRICS_EXPORT_POLL_INTERVAL_MS 250
+
+// Longest request we read, and how long a client may take to send or receive
+#define METRICS_EXPORT_REQUEST_SIZE 2048
+#define METRICS_EXPORT_CLIENT_TIMEOUT_MS 1000
+
+// Define the actual exporter implementation structure
+struct MetricsExporterImpl {
+    MetricsRegistry registry;
+    MetricsExporterConfig config;
+    
+    // Endpoint socket (-1 without one)
+    int listen_socket;
+    
+    // Export file and the name it is written under first (NULL without one)
+    char* path;
+    char* temporary_path;
+    bool reported_write_error;
+    
+    pthread_t thread;
+    atomic_bool running;
+};
+
+static double current_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+// Replace the export file with the current metrics
+static void write_file(MetricsExporter exporter) {
+    FILE* file = fopen(exporter->temporary_path, "w");
+    bool written = file && metrics_write_text(exporter->registry, file);
+    if (file && fclose(file) != 0) {
+        written = false;
+    }
+    if (written && rename(exporter->temporary_path, exporter->path) == 0) {
+        exporter->reported_write_error = false;
+        return;
+    }
+    
+    // Report a failing file once rather than every interval
+    if (!exporter->reported_write_error) {
+        fprintf(stderr, "Failed to write metrics to %s: %s\n", exporter->path, strerror(errno));
+        exporter->reported_write_error = true;
+    }
+    if (file) {
+        remove(exporter->temporary_path);
+    }
+}
+
+// Send all of a buffer, giving up if the client stops reading
+static bool send_all(int client, const char* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+    while (size > 0) {
+        ssize_t sent = send(client, data, size, flags);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+static void send_response(int client, const char* status, const char* content_type, const char* body,
+                          size_t body_size, bool head) {
+    char header[256];
+    int header_size = snprintf(header, sizeof(header),
+                               "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                               status, content_type, body_size);
+    if (send_all(client, header, (size_t)header_size) && !head) {
+        send_all(client, body, body_size);
+    }
+}
+
+// Answer one request; only GET (or HEAD) /metrics is served
+static void serve_client(MetricsExporter exporter, int client) {
+    struct timeval timeout;
+    timeout.tv_sec = METRICS_EXPORT_CLIENT_TIMEOUT_MS / 1000;
+    timeout.tv_usec = (METRICS_EXPORT_CLIENT_TIMEOUT_MS % 1000) * 1000;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    int no_sigpipe = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+    
+    // Read up to the end of the headers; the request line is all we need
+    char request[METRICS_EXPORT_REQUEST_SIZE];
+    size_t length = 0;
+    while (length < sizeof(request) - 1) {
+        ssize_t received = recv(client, request + length, sizeof(request) - 1 - length, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        length += (size_t)received;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n")) break;
+    }
+    request[length] = '\0';
+    
+    char method[8] = "", target[256] = "";
+    if (sscanf(request, "%7s %255s", method, target) != 2) {
+        const char* body = "Bad request\n";
+        send_response(client, "400 Bad Request", "text/plain", body, strlen(body), false);
+        return;
+    }
+    bool head = strcmp(method, "HEAD") == 0;
+    if (!head && strcmp(method, "GET") != 0) {
+        const char* body = "Only GET is supported\n";
+        send_response(client, "405 Method Not Allowed", "text/plain", body, strlen(body), false);
+        return;
+    }
+    char* query = strchr(target, '?');
+    if (query) {
+        *query = '\0';
+    }
+    if (strcmp(target, "/metrics") != 0) {
+        const char* body = "Metrics are at /metrics\n";
+        send_response(client, "404 Not Found", "text/plain", body, strlen(body), head);
+        return;
+    }
+    
+    char* body = NULL;
+    size_t body_size = 0;
+    FILE* stream = open_memstream(&body, &body_size);
+    bool written = stream && metrics_write_text(exporter->registry, stream);
+    if (stream) {
+        fclose(stream);
+    }
+    if (written) {
+        send_response(client, "200 OK", "text/plain; version=0.0.4; charset=utf-8", body, body_size, head);
+    } else {
+        const char* error = "Failed to export metrics\n";
+        send_response(client, "500 Internal Server Error", "text/plain", error, strlen(error), head);
+    }
+    free(body);
+}
+
+static void* export_thread(void* arg) {
+    MetricsExporter exporter = (MetricsExporter)arg;
+    double next_write = current_seconds();
+    
+    while (atomic_load(&exporter->running)) {
+        long wait_ms = METRICS_EXPORT_POLL_INTERVAL_MS;
+        if (exporter->path) {
+            double now = current_seconds();
+            if (now >= next_write) {
+                write_file(exporter);
+                next_write = now + exporter->config.interval;
+            }
+            long until_write = (long)((next_write - now) * 1000.0) + 1;
+            wait_ms = until_write < wait_ms ? until_write : wait_ms;
+        }
+        
+        if (exporter->listen_socket < 0) {
+            sleep_ms(wait_ms);
+            continue;
+        }
+        
+        // Scrapes are rare, so they are answered one at a time on this thread
+        struct pollfd listener;
+        listener.fd = exporter->listen_socket;
+        listener.events = POLLIN;
+        if (poll(&listener, 1, (int)wait_ms) > 0 && (listener.revents & POLLIN)) {
+            int client = accept(exporter->listen_socket, NULL, NULL);
+            if (client >= 0) {
+                serve_client(exporter, client);
+                close(client);
+            }
+        }
+    }
+    
+    // Leave the final values behind
+    if (exporter->path) {
+        write_file(exporter);
+    }
+    return NULL;
+}
+
+// Listen on the loopback interface only; metrics are not meant for the network
+static int open_listen_socket(int port) {
+    int listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_socket < 0) {
+        fprintf(stderr, "Failed to create metrics socket: %s\n", strerror(errno));
+        return -1;
+    }
+    
+    int reuse = 1;
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listen_socket, 8) != 0) {
+        fprintf(stderr, "Failed to serve metrics on port %d: %s\n", port, strerror(errno));
+        close(listen_socket);
+        return -1;
+    }
+    return listen_socket;
+}
+
+MetricsExporterConfig metrics_exporter_config_default(void) {
+    MetricsExporterConfig config;
+    config.port = 0;
+    config.path = NULL;
+    config.interval = 1.0;
+    return config;
+}
+
+MetricsExporter metrics_exporter_create(MetricsRegistry registry, MetricsExporterConfig config) {
+    if (!registry || config.port < 0 || config.port > 65535 || !(config.interval > 0.0)) {
+        fprintf(stderr, "Invalid metrics exporter configuration\n");
+        return NULL;
+    }
+    
+    MetricsExporter exporter = (MetricsExporter)calloc(1, sizeof(struct MetricsExporterImpl));
+    if (!exporter) {
+        fprintf(stderr, "Failed to allocate metrics exporter\n");
+        return NULL;
+    }
+    exporter->registry = registry;
+    exporter->config = config;
+    exporter->listen_socket = -1;
+    
+    if (config.path) {
+        size_t length = strlen(config.path);
+        exporter->path = (char*)malloc(length + 1);
+        exporter->temporary_path = (char*)malloc(length + 5);
+        if (!exporter->path || !exporter->temporary_path) {
+            fprintf(stderr, "Failed to allocate metrics exporter\n");
+            metrics_exporter_destroy(exporter);
+            return NULL;
+        }
+        memcpy(exporter->path, config.path, length + 1);
+        snprintf(exporter->temporary_path, length + 5, "%s.tmp", config.path);
+    }
+    
+    if (config.port > 0) {
+        exporter->listen_socket = open_listen_socket(config.port);
+        if (exporter->listen_socket < 0) {
+            metrics_exporter_destroy(exporter);
+            return NULL;
+        }
+    }
+    
+    atomic_store(&exporter->running, true);
+    if (pthread_create(&exporter->thread, NULL, export_thread, exporter) != 0) {
+        fprintf(stderr, "Failed to start metrics exporter thread\n");
+        atomic_store(&exporter->running, false);
+        metrics_exporter_destroy(exporter);
+        return NULL;
+    }
+    
+    if (config.port > 0) {
+        printf("Serving metrics at http://127.0.0.1:%d/metrics\n", config.port);
+    }
+    return exporter;
+}
+
+void metrics_exporter_destroy(MetricsExporter exporter) {
+    if (!exporter) return;
+    
+    if (atomic_load(&exporter->running)) {
+        atomic_store(&exporter->running, false);
+        pthread_join(exporter->thread, NULL);
+    }
+    if (exporter->listen_socket >= 0) {
+        close(exporter->listen_socket);
+    }
+    free(exporter->path);
+    free(exporter->temporary_path);
+    free(exporter);
+}
\ No newline at end of file
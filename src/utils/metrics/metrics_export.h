@@ -0,0 +1,30 @@
+#ifndef METRICS_EXPORT_H
+#define METRICS_EXPORT_H
+
+#include "metrics.h"
+
+// Metrics exporter configuration structure
+typedef struct {
+    int port; // Serve GET /metrics on 127.0.0.1 at this port (0 for no endpoint)
+    const char* path; // File rewritten with the metrics (NULL for none)
+    double interval; // Seconds between file writes
+} MetricsExporterConfig;
+
+// Opaque handle for a metrics exporter
+// A background thread that answers scrapes of a registry in the Prometheus
+// text format and/or periodically replaces a file with it, e.g. for the
+// node exporter's textfile collector. Files are written to a temporary name
+// and renamed, so readers never see a partial export.
+typedef struct MetricsExporterImpl* MetricsExporter;
+
+// Default exporter configuration (no endpoint, no file, one second interval)
+MetricsExporterConfig metrics_exporter_config_default(void);
+
+// Start exporting a registry, which must outlive the exporter
+// Returns NULL if the port cannot be bound or the thread cannot start.
+MetricsExporter metrics_exporter_create(MetricsRegistry registry, MetricsExporterConfig config);
+
+// Stop the thread, writing the file a last time
+void metrics_exporter_destroy(MetricsExporter exporter);
+
+#endif /* METRICS_EXPORT_H */
\ No newline at end of file
@@ -1,9 +1,5 @@
 #include "cube.h"
-#include "../shader/shader.h"
-#include "../math/math.h"
 #include <stdlib.h>
-#include <string.h>
-#include <math.h>
 
 #ifdef __APPLE__
 #include <OpenGL/gl3.h>
@@ -11,27 +7,52 @@
 #include <glad/glad.h>
 #endif
 
-// Cube vertices (position and color)
+// Cube vertices (position, color, normal and texture coordinates)
+// Every face has its own four corners so each can carry the face normal.
+// Texture coordinates run left to right and bottom to top as seen from
+// outside, followed by the face number.
 static float vertices[] = {
-    // positions          // colors
-    -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
-     0.5f, -0.5f, -0.5f,  1.0f, 0.5f, 0.0f,
-     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,
-    -0.5f,  0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
-     0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.5f,
-     0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f, 0.5f, 1.0f
+    // positions          // colors          // normals             // texture coordinates
+    // Front face
+    -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, -1.0f,   1.0f, 0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f, 0.5f, 0.0f,   0.0f,  0.0f, -1.0f,   0.0f, 0.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,   0.0f, 1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.5f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,   1.0f, 1.0f, 0.0f,
+    // Right face
+     0.5f, -0.5f, -0.5f,  1.0f, 0.5f, 0.0f,   1.0f,  0.0f,  0.0f,   1.0f, 0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.5f,   1.0f,  0.0f,  0.0f,   0.0f, 0.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,   1.0f,  0.0f,  0.0f,   0.0f, 1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,   1.0f,  0.0f,  0.0f,   1.0f, 1.0f, 1.0f,
+    // Back face
+     0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.5f,   0.0f,  0.0f,  1.0f,   1.0f, 0.0f, 2.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f,  1.0f,   0.0f, 0.0f, 2.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 0.5f, 1.0f,   0.0f,  0.0f,  1.0f,   0.0f, 1.0f, 2.0f,
+     0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,   0.0f,  0.0f,  1.0f,   1.0f, 1.0f, 2.0f,
+    // Left face
+    -0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,  -1.0f,  0.0f,  0.0f,   1.0f, 0.0f, 3.0f,
+    -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,  -1.0f,  0.0f,  0.0f,   0.0f, 0.0f, 3.0f,
+    -0.5f,  0.5f, -0.5f,  0.5f, 1.0f, 0.0f,  -1.0f,  0.0f,  0.0f,   0.0f, 1.0f, 3.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 0.5f, 1.0f,  -1.0f,  0.0f,  0.0f,   1.0f, 1.0f, 3.0f,
+    // Top face
+    -0.5f,  0.5f, -0.5f,  0.5f, 1.0f, 0.0f,   0.0f,  1.0f,  0.0f,   1.0f, 0.0f, 4.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,   0.0f,  1.0f,  0.0f,   0.0f, 0.0f, 4.0f,
+     0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,   0.0f,  1.0f,  0.0f,   0.0f, 1.0f, 4.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 0.5f, 1.0f,   0.0f,  1.0f,  0.0f,   1.0f, 1.0f, 4.0f,
+    // Bottom face
+    -0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,   0.0f, -1.0f,  0.0f,   1.0f, 0.0f, 5.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.5f,   0.0f, -1.0f,  0.0f,   0.0f, 0.0f, 5.0f,
+     0.5f, -0.5f, -0.5f,  1.0f, 0.5f, 0.0f,   0.0f, -1.0f,  0.0f,   0.0f, 1.0f, 5.0f,
+    -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,   0.0f, -1.0f,  0.0f,   1.0f, 1.0f, 5.0f
 };
 
 // Cube indices
 static unsigned int indices[] = {
-    0, 1, 2, 2, 3, 0, // Front face
-    1, 5, 6, 6, 2, 1, // Right face
-    5, 4, 7, 7, 6, 5, // Back face
-    4, 0, 3, 3, 7, 4, // Left face
-    3, 2, 6, 6, 7, 3, // Top face
-    4, 5, 1, 1, 0, 4  // Bottom face
+    0, 1, 2, 2, 3, 0,       // Front face
+    4, 5, 6, 6, 7, 4,       // Right face
+    8, 9, 10, 10, 11, 8,    // Back face
+    12, 13, 14, 14, 15, 12, // Left face
+    16, 17, 18, 18, 19, 16, // Top face
+    20, 21, 22, 22, 23, 20  // Bottom face
 };
 
 Cube* cube_create(void) {
@@ -40,74 +61,66 @@ Cube* cube_create(void) {
         return NULL;
     }
     
-    // Initialize rotation angle
-    cube->rotation_angle = 0.0f;
-    
-    // Generate and bind Vertex Array Object
-    glGenVertexArrays(1, &cube->vao);
-    glBindVertexArray(cube->vao);
-    
-    // Generate and bind Vertex Buffer Object
+    // Generate and fill Vertex Buffer Object
     glGenBuffers(1, &cube->vbo);
     glBindBuffer(GL_ARRAY_BUFFER, cube->vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     
-    // Generate and bind Element Buffer Object
+    // Generate and fill Element Buffer Object
     glGenBuffers(1, &cube->ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cube->ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    
+    return cube;
+}
+
+unsigned int cube_create_vertex_array(Cube* cube) {
+    if (!cube) return 0;
+    
+    // Generate and bind Vertex Array Object
+    unsigned int vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    
+    // Attach the shared buffers
+    glBindBuffer(GL_ARRAY_BUFFER, cube->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cube->ebo);
     
     // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     
     // Color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
     
+    // Normal attribute (location 2 is left for per-instance data)
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(3);
+    
+    // Texture coordinate and face attribute
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(9 * sizeof(float)));
+    glEnableVertexAttribArray(4);
+    
     // Unbind
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     
-    return cube;
+    return vao;
 }
 
-void cube_render(Cube* cube, ShaderProgram shader_program, float delta_time, float rotation_speed) {
-    if (!cube) return;
-    
-    // Update rotation angle
-    cube->rotation_angle += rotation_speed * delta_time;
-    
-    // Create transformation matrices
-    float model[16], rotation_y[16], rotation_x[16], translation[16], temp[16];
+void cube_draw_instanced(Cube* cube, int instance_count) {
+    if (!cube || instance_count <= 0) return;
     
-    // Create rotation matrices
-    matrix_rotate_y(rotation_y, cube->rotation_angle);
-    matrix_rotate_x(rotation_x, cube->rotation_angle * 0.5f);
-    
-    // Combine rotations
-    matrix_multiply(temp, rotation_y, rotation_x);
-    
-    // Create translation matrix to center the cube (if needed)
-    matrix_translate(translation, 0.0f, 0.0f, 0.0f);
-    
-    // Combine translation and rotation for final model matrix
-    matrix_multiply(model, translation, temp);
-    
-    // Set model uniform
-    shader_set_mat4(shader_program, "model", model);
-    
-    // Draw the cube
-    glBindVertexArray(cube->vao);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, instance_count);
 }
 
 void cube_destroy(Cube* cube) {
     if (!cube) return;
     
-    // Delete buffers and vertex array
-    glDeleteVertexArrays(1, &cube->vao);
+    // Delete buffers
     glDeleteBuffers(1, &cube->vbo);
     glDeleteBuffers(1, &cube->ebo);
     
@@ -3,22 +3,23 @@
 
 #include <stdbool.h>
 
-// Forward declaration for shader program
-typedef unsigned int ShaderProgram;
-
 // Cube object structure
+// Owns the vertex and index buffers, which are shared between contexts
 typedef struct {
-    unsigned int vao;
     unsigned int vbo;
     unsigned int ebo;
-    float rotation_angle;
 } Cube;
 
 // Create a new cube
 Cube* cube_create(void);
 
-// Render the cube with the given shader program
-void cube_render(Cube* cube, ShaderProgram shader_program, float delta_time, float rotation_speed);
+// Create a vertex array for the current GL context using the cube's buffers
+// Buffers are shared between contexts but vertex arrays are not, so every
+// additional window needs its own
+unsigned int cube_create_vertex_array(Cube* cube);
+
+// Draw instance_count cubes using the currently bound vertex array
+void cube_draw_instanced(Cube* cube, int instance_count);
 
 // Destroy the cube and free resources
 void cube_destroy(Cube* cube);
@@ -0,0 +1,398 @@
+#include "occlusion_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Enough levels for a 65536 texel wide buffer
+#define OCCLUSION_MAX_LEVELS 17
+
+// Depth of an empty texel (the far plane)
+#define OCCLUSION_FAR_DEPTH 1.0f
+
+// Corners of the unit cube, matching the cube mesh
+static const float box_corners[8][3] = {
+    { -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+    { -0.5f, -0.5f,  0.5f }, { 0.5f, -0.5f,  0.5f }, { 0.5f, 0.5f,  0.5f }, { -0.5f, 0.5f,  0.5f }
+};
+
+// Faces of the unit cube, wound clockwise when seen from outside
+static const int box_faces[6][4] = {
+    { 0, 1, 2, 3 }, // Front face
+    { 1, 5, 6, 2 }, // Right face
+    { 5, 4, 7, 6 }, // Back face
+    { 4, 0, 3, 7 }, // Left face
+    { 3, 2, 6, 7 }, // Top face
+    { 4, 5, 1, 0 }  // Bottom face
+};
+
+// A box projects to a convex polygon of at most six corners; the hull is
+// built in a buffer with room for every corner twice
+#define OCCLUSION_MAX_HULL 16
+
+// Define the actual occlusion buffer implementation structure
+struct OcclusionBufferImpl {
+    float view_projection[16];
+    
+    // Level 0 holds the nearest depth per texel, every further level the
+    // farthest depth of the 2x2 texels below it
+    float* levels[OCCLUSION_MAX_LEVELS];
+    int level_width[OCCLUSION_MAX_LEVELS];
+    int level_height[OCCLUSION_MAX_LEVELS];
+    int level_count;
+};
+
+// A corner projected to the buffer: texel coordinates and depth in [0, 1]
+typedef struct {
+    float x;
+    float y;
+    float z;
+} ScreenVertex;
+
+// Screen-space function f(x, y) = a * x + b * y + c, used both for edges
+// (inside where non-negative) and for depth planes
+typedef struct {
+    float a;
+    float b;
+    float c;
+} Plane2D;
+
+// Project the corners of a transformed unit cube into clip space
+static void transform_box(const float* view_projection, const float* model, float clip[8][4]) {
+    // Combined matrix, column-major like the rest of the math code
+    float mvp[16];
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            mvp[c * 4 + r] = view_projection[r] * model[c * 4] +
+                             view_projection[4 + r] * model[c * 4 + 1] +
+                             view_projection[8 + r] * model[c * 4 + 2] +
+                             view_projection[12 + r] * model[c * 4 + 3];
+        }
+    }
+    
+    for (int i = 0; i < 8; i++) {
+        const float* p = box_corners[i];
+        for (int r = 0; r < 4; r++) {
+            clip[i][r] = mvp[r] * p[0] + mvp[4 + r] * p[1] + mvp[8 + r] * p[2] + mvp[12 + r];
+        }
+    }
+}
+
+// Map clip coordinates to texel coordinates; false if behind the near plane
+static bool project_vertex(OcclusionBuffer buffer, const float* clip, ScreenVertex* out) {
+    if (clip[3] <= 1e-6f || clip[2] < -clip[3]) {
+        return false;
+    }
+    
+    float inv_w = 1.0f / clip[3];
+    out->x = (clip[0] * inv_w * 0.5f + 0.5f) * (float)buffer->level_width[0];
+    out->y = (clip[1] * inv_w * 0.5f + 0.5f) * (float)buffer->level_height[0];
+    out->z = clip[2] * inv_w * 0.5f + 0.5f;
+    return true;
+}
+
+// Twice the signed area of a screen triangle, positive when counter-clockwise
+static float signed_area(const ScreenVertex* v0, const ScreenVertex* v1, const ScreenVertex* v2) {
+    return (v1->x - v0->x) * (v2->y - v0->y) - (v2->x - v0->x) * (v1->y - v0->y);
+}
+
+// Convex hull of the projected corners, counter-clockwise (monotone chain)
+// Returns the number of hull corners
+static int convex_hull(const ScreenVertex* vertices, int count, ScreenVertex* hull) {
+    ScreenVertex sorted[8];
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        while (j > 0 && (sorted[j - 1].x > vertices[i].x ||
+                         (sorted[j - 1].x == vertices[i].x && sorted[j - 1].y > vertices[i].y))) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = vertices[i];
+    }
+    
+    int size = 0;
+    for (int i = 0; i < count; i++) {
+        while (size >= 2 && signed_area(&hull[size - 2], &hull[size - 1], &sorted[i]) <= 0.0f) size--;
+        hull[size++] = sorted[i];
+    }
+    for (int i = count - 2, lower = size + 1; i >= 0; i--) {
+        while (size >= lower && signed_area(&hull[size - 2], &hull[size - 1], &sorted[i]) <= 0.0f) size--;
+        hull[size++] = sorted[i];
+    }
+    return size - 1;
+}
+
+// Rasterize the silhouette of a box, keeping the nearest depth per texel
+// To stay conservative a texel is only written if the silhouette covers all
+// of it, with the farthest depth the box's surface reaches inside it. The
+// surface of a convex box is the farthest of its front face planes.
+static void rasterize_box(OcclusionBuffer buffer, const ScreenVertex* hull, int hull_count,
+                          const Plane2D* planes, int plane_count) {
+    int width = buffer->level_width[0];
+    int height = buffer->level_height[0];
+    
+    // Edges with the inside offset by half a texel, so e >= 0 means covered
+    Plane2D edges[OCCLUSION_MAX_HULL];
+    float min_x = hull[0].x, max_x = hull[0].x, min_y = hull[0].y, max_y = hull[0].y;
+    for (int i = 0; i < hull_count; i++) {
+        const ScreenVertex* p = &hull[i];
+        const ScreenVertex* q = &hull[(i + 1) % hull_count];
+        edges[i].a = p->y - q->y;
+        edges[i].b = q->x - p->x;
+        edges[i].c = p->x * q->y - q->x * p->y - 0.5f * (fabsf(edges[i].a) + fabsf(edges[i].b));
+        min_x = fminf(min_x, p->x);
+        max_x = fmaxf(max_x, p->x);
+        min_y = fminf(min_y, p->y);
+        max_y = fmaxf(max_y, p->y);
+    }
+    
+    // Texels whose centers lie half a texel inside the bounds, with x aligned for SIMD
+    int x0 = (int)ceilf(fmaxf(min_x, 0.0f));
+    int x1 = (int)floorf(fminf(max_x, (float)width)) - 1;
+    int y0 = (int)ceilf(fmaxf(min_y, 0.0f));
+    int y1 = (int)floorf(fminf(max_y, (float)height)) - 1;
+    if (x0 > x1 || y0 > y1) return;
+    x0 &= ~3;
+    
+    float* depth = buffer->levels[0];
+    for (int y = y0; y <= y1; y++) {
+        float py = (float)y + 0.5f;
+        float* row = depth + (size_t)y * (size_t)width;
+        
+#ifdef __SSE2__
+        // Four texels at a time; rows are padded to a multiple of 4
+        __m128 zero = _mm_setzero_ps();
+        __m128 far_depth = _mm_set1_ps(OCCLUSION_FAR_DEPTH);
+        __m128 lane = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        for (int x = x0; x <= x1; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lane);
+            
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int i = 0; i < hull_count; i++) {
+                __m128 e = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(edges[i].a)),
+                                      _mm_set1_ps(edges[i].b * py + edges[i].c));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(e, zero));
+            }
+            if (!_mm_movemask_ps(inside)) continue;
+            
+            __m128 z = zero;
+            for (int i = 0; i < plane_count; i++) {
+                __m128 plane = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(planes[i].a)),
+                                          _mm_set1_ps(planes[i].b * py + planes[i].c));
+                z = _mm_max_ps(z, plane);
+            }
+            
+            __m128 old = _mm_loadu_ps(row + x);
+            __m128 nearest = _mm_min_ps(old, _mm_min_ps(z, far_depth));
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+        }
+#else
+        for (int x = x0; x <= x1; x++) {
+            float px = (float)x + 0.5f;
+            
+            bool inside = true;
+            for (int i = 0; i < hull_count && inside; i++) {
+                inside = edges[i].a * px + edges[i].b * py + edges[i].c >= 0.0f;
+            }
+            if (!inside) continue;
+            
+            float z = 0.0f;
+            for (int i = 0; i < plane_count; i++) {
+                z = fmaxf(z, planes[i].a * px + planes[i].b * py + planes[i].c);
+            }
+            z = fminf(z, OCCLUSION_FAR_DEPTH);
+            if (z < row[x]) row[x] = z;
+        }
+#endif
+    }
+}
+
+OcclusionBuffer occlusion_buffer_create(int width, int height) {
+    if (width <= 0 || height <= 0) return NULL;
+    
+    OcclusionBuffer buffer = (OcclusionBuffer)calloc(1, sizeof(struct OcclusionBufferImpl));
+    if (!buffer) {
+        fprintf(stderr, "Failed to allocate occlusion buffer\n");
+        return NULL;
+    }
+    
+    // Halve down to a single texel
+    width = (width + 3) & ~3;
+    while (buffer->level_count < OCCLUSION_MAX_LEVELS) {
+        int level = buffer->level_count++;
+        buffer->level_width[level] = width;
+        buffer->level_height[level] = height;
+        buffer->levels[level] = (float*)malloc((size_t)width * (size_t)height * sizeof(float));
+        if (!buffer->levels[level]) {
+            fprintf(stderr, "Failed to allocate occlusion buffer\n");
+            occlusion_buffer_destroy(buffer);
+            return NULL;
+        }
+        
+        if (width == 1 && height == 1) break;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+    
+    return buffer;
+}
+
+void occlusion_buffer_begin(OcclusionBuffer buffer, const float* view_projection) {
+    if (!buffer) return;
+    
+    for (int i = 0; i < 16; i++) {
+        buffer->view_projection[i] = view_projection[i];
+    }
+    
+    size_t count = (size_t)buffer->level_width[0] * (size_t)buffer->level_height[0];
+    float* depth = buffer->levels[0];
+    for (size_t i = 0; i < count; i++) {
+        depth[i] = OCCLUSION_FAR_DEPTH;
+    }
+}
+
+void occlusion_buffer_draw_box(OcclusionBuffer buffer, const float* model) {
+    if (!buffer) return;
+    
+    float clip[8][4];
+    transform_box(buffer->view_projection, model, clip);
+    
+    ScreenVertex vertices[8];
+    for (int i = 0; i < 8; i++) {
+        if (!project_vertex(buffer, clip[i], &vertices[i])) {
+            return;
+        }
+    }
+    
+    // A mirroring transform flips the winding of every face
+    float determinant = model[0] * (model[5] * model[10] - model[9] * model[6]) -
+                        model[4] * (model[1] * model[10] - model[9] * model[2]) +
+                        model[8] * (model[1] * model[6] - model[5] * model[2]);
+    float front_sign = determinant < 0.0f ? 1.0f : -1.0f;
+    
+    // Depth planes of the front faces, which are clockwise from outside and so
+    // clockwise on screen too once the y axis points up. Each plane is raised
+    // to its farthest value within a texel.
+    Plane2D planes[3];
+    int plane_count = 0;
+    for (int f = 0; f < 6; f++) {
+        const ScreenVertex* v0 = &vertices[box_faces[f][0]];
+        const ScreenVertex* v1 = &vertices[box_faces[f][1]];
+        const ScreenVertex* v2 = &vertices[box_faces[f][2]];
+        float area = signed_area(v0, v1, v2) * front_sign;
+        if (area <= 0.0f) continue;
+        if (area < 1e-6f || plane_count == 3) {
+            // Seen edge-on; the depth slope is unusable
+            return;
+        }
+        
+        float e0_a = v1->y - v2->y, e0_b = v2->x - v1->x, e0_c = v1->x * v2->y - v2->x * v1->y;
+        float e1_a = v2->y - v0->y, e1_b = v0->x - v2->x, e1_c = v2->x * v0->y - v0->x * v2->y;
+        float e2_a = v0->y - v1->y, e2_b = v1->x - v0->x, e2_c = v0->x * v1->y - v1->x * v0->y;
+        float inv_area = front_sign / area;
+        Plane2D* plane = &planes[plane_count++];
+        plane->a = (e0_a * v0->z + e1_a * v1->z + e2_a * v2->z) * inv_area;
+        plane->b = (e0_b * v0->z + e1_b * v1->z + e2_b * v2->z) * inv_area;
+        plane->c = (e0_c * v0->z + e1_c * v1->z + e2_c * v2->z) * inv_area +
+                   0.5f * (fabsf(plane->a) + fabsf(plane->b));
+    }
+    if (plane_count == 0) return;
+    
+    ScreenVertex hull[OCCLUSION_MAX_HULL];
+    int hull_count = convex_hull(vertices, 8, hull);
+    if (hull_count < 3) return;
+    
+    rasterize_box(buffer, hull, hull_count, planes, plane_count);
+}
+
+void occlusion_buffer_build_pyramid(OcclusionBuffer buffer) {
+    if (!buffer) return;
+    
+    for (int level = 1; level < buffer->level_count; level++) {
+        const float* source = buffer->levels[level - 1];
+        int source_width = buffer->level_width[level - 1];
+        int source_height = buffer->level_height[level - 1];
+        float* target = buffer->levels[level];
+        int width = buffer->level_width[level];
+        int height = buffer->level_height[level];
+        
+        for (int y = 0; y < height; y++) {
+            // Odd sizes repeat the last row or column
+            const float* row0 = source + (size_t)(y * 2) * (size_t)source_width;
+            const float* row1 = source + (size_t)(y * 2 + 1 < source_height ? y * 2 + 1 : y * 2) * (size_t)source_width;
+            for (int x = 0; x < width; x++) {
+                int x0 = x * 2;
+                int x1 = x0 + 1 < source_width ? x0 + 1 : x0;
+                target[(size_t)y * (size_t)width + x] = fmaxf(fmaxf(row0[x0], row0[x1]), fmaxf(row1[x0], row1[x1]));
+            }
+        }
+    }
+}
+
+bool occlusion_buffer_test_box(OcclusionBuffer buffer, const float* model) {
+    if (!buffer) return true;
+    
+    float clip[8][4];
+    transform_box(buffer->view_projection, model, clip);
+    
+    // Screen rectangle and nearest depth of the box
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    float min_z = INFINITY;
+    for (int i = 0; i < 8; i++) {
+        ScreenVertex vertex;
+        if (!project_vertex(buffer, clip[i], &vertex)) {
+            // Reaches the camera, so nothing can hide it
+            return true;
+        }
+        min_x = fminf(min_x, vertex.x);
+        max_x = fmaxf(max_x, vertex.x);
+        min_y = fminf(min_y, vertex.y);
+        max_y = fmaxf(max_y, vertex.y);
+        min_z = fminf(min_z, vertex.z);
+    }
+    
+    int width = buffer->level_width[0];
+    int height = buffer->level_height[0];
+    int x0 = (int)floorf(fmaxf(min_x, 0.0f));
+    int y0 = (int)floorf(fmaxf(min_y, 0.0f));
+    int x1 = (int)floorf(fminf(max_x, (float)(width - 1)));
+    int y1 = (int)floorf(fminf(max_y, (float)(height - 1)));
+    if (x0 > x1 || y0 > y1) {
+        // Off screen; the frustum test is the authority on that
+        return true;
+    }
+    
+    // Go up the pyramid until the rectangle covers at most 4x4 texels; any
+    // coarser and texels straddling the occluders' edges hide too much
+    int level = 0;
+    while ((x1 - x0 > 3 || y1 - y0 > 3) && level + 1 < buffer->level_count) {
+        x0 >>= 1;
+        y0 >>= 1;
+        x1 >>= 1;
+        y1 >>= 1;
+        level++;
+    }
+    
+    const float* depth = buffer->levels[level];
+    int level_width = buffer->level_width[level];
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            if (min_z <= depth[(size_t)y * (size_t)level_width + x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void occlusion_buffer_destroy(OcclusionBuffer buffer) {
+    if (!buffer) return;
+    
+    for (int i = 0; i < buffer->level_count; i++) {
+        free(buffer->levels[i]);
+    }
+    free(buffer);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include <stdbool.h>
+
+// Opaque handle for an occlusion buffer
+// A low-resolution depth buffer rasterized on the CPU from a set of occluder
+// boxes, with a pyramid of maximum depths for testing bounding boxes against it
+typedef struct OcclusionBufferImpl* OcclusionBuffer;
+
+// Create an occlusion buffer; width is rounded up to a multiple of 4
+OcclusionBuffer occlusion_buffer_create(int width, int height);
+
+// Clear the buffer and set the projection * view matrix used from now on
+void occlusion_buffer_begin(OcclusionBuffer buffer, const float* view_projection);
+
+// Rasterize the unit cube transformed by model as an occluder
+// Boxes crossing the near plane are skipped, which is always safe
+void occlusion_buffer_draw_box(OcclusionBuffer buffer, const float* model);
+
+// Build the depth pyramid; call after the last occluder and before testing
+void occlusion_buffer_build_pyramid(OcclusionBuffer buffer);
+
+// Check whether the unit cube transformed by model may be visible
+// Returns false only if it is entirely behind the occluders
+bool occlusion_buffer_test_box(OcclusionBuffer buffer, const float* model);
+
+// Destroy the occlusion buffer
+void occlusion_buffer_destroy(OcclusionBuffer buffer);
+
+#endif /* OCCLUSION_BUFFER_H */
\ No newline at end of file
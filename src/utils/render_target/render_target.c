@@ -0,0 +1,301 @@
+#include "render_target.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <glad/glad.h>
+#endif
+
+// Define the actual render target implementation structure
+struct RenderTargetImpl {
+    RenderTargetConfig config;
+    unsigned int framebuffer;
+    unsigned int color_texture;
+    unsigned int color_buffer; // Multisampled color
+    unsigned int depth_texture;
+    unsigned int depth_buffer;
+    int layer; // Layer of array textures currently attached
+};
+
+// Texture type of the target's attachments
+static GLenum texture_target(RenderTarget target) {
+    return target->config.layers > 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+}
+
+// Allocate one texture attachment and attach its first layer
+static unsigned int create_texture(RenderTarget target, GLenum attachment, GLint internal_format, GLenum format,
+                                   GLenum type, GLint filter) {
+    const RenderTargetConfig* config = &target->config;
+    GLenum kind = texture_target(target);
+    
+    unsigned int texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(kind, texture);
+    if (config->layers > 0) {
+        glTexImage3D(kind, 0, internal_format, config->width, config->height, config->layers, 0, format, type, NULL);
+    } else {
+        glTexImage2D(kind, 0, internal_format, config->width, config->height, 0, format, type, NULL);
+    }
+    glTexParameteri(kind, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(kind, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(kind, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(kind, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    if (config->layers > 0) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, attachment, texture, 0, 0);
+    } else {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, kind, texture, 0);
+    }
+    return texture;
+}
+
+// Delete the attachments, keeping the framebuffer object
+static void release_attachments(RenderTarget target) {
+    if (target->color_texture) {
+        glDeleteTextures(1, &target->color_texture);
+        target->color_texture = 0;
+    }
+    if (target->color_buffer) {
+        glDeleteRenderbuffers(1, &target->color_buffer);
+        target->color_buffer = 0;
+    }
+    if (target->depth_texture) {
+        glDeleteTextures(1, &target->depth_texture);
+        target->depth_texture = 0;
+    }
+    if (target->depth_buffer) {
+        glDeleteRenderbuffers(1, &target->depth_buffer);
+        target->depth_buffer = 0;
+    }
+}
+
+// Allocate one renderbuffer attachment with the target's sample count
+static unsigned int create_renderbuffer(RenderTarget target, GLenum attachment, GLenum internal_format) {
+    const RenderTargetConfig* config = &target->config;
+    
+    unsigned int renderbuffer = 0;
+    glGenRenderbuffers(1, &renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    if (config->samples > 1) {
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, config->samples, internal_format, config->width, config->height);
+    } else {
+        glRenderbufferStorage(GL_RENDERBUFFER, internal_format, config->width, config->height);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, renderbuffer);
+    return renderbuffer;
+}
+
+// (Re)create the attachments at the configured size
+static bool create_attachments(RenderTarget target) {
+    const RenderTargetConfig* config = &target->config;
+    
+    // Start from a clean error state so failures below are ours
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    
+    release_attachments(target);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+    target->layer = 0;
+    
+    bool multisampled = config->samples > 1;
+    switch (config->color) {
+        case RENDER_TARGET_COLOR_RGBA8:
+            if (multisampled) {
+                target->color_buffer = create_renderbuffer(target, GL_COLOR_ATTACHMENT0, GL_RGBA8);
+                break;
+            }
+            target->color_texture = create_texture(target, GL_COLOR_ATTACHMENT0, GL_RGBA8, GL_RGBA,
+                                                   GL_UNSIGNED_BYTE, GL_LINEAR);
+            break;
+        case RENDER_TARGET_COLOR_R32UI:
+            if (multisampled) {
+                target->color_buffer = create_renderbuffer(target, GL_COLOR_ATTACHMENT0, GL_R32UI);
+                break;
+            }
+            target->color_texture = create_texture(target, GL_COLOR_ATTACHMENT0, GL_R32UI, GL_RED_INTEGER,
+                                                   GL_UNSIGNED_INT, GL_NEAREST);
+            break;
+        case RENDER_TARGET_COLOR_NONE:
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+            break;
+    }
+    
+    switch (config->depth) {
+        case RENDER_TARGET_DEPTH_BUFFER:
+            target->depth_buffer = create_renderbuffer(target, GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT24);
+            break;
+        case RENDER_TARGET_DEPTH_TEXTURE:
+            // Linear filtering of a comparison gives 2x2 percentage-closer filtering
+            target->depth_texture = create_texture(target, GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT32F,
+                                                   GL_DEPTH_COMPONENT, GL_FLOAT, GL_LINEAR);
+            glTexParameteri(texture_target(target), GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(texture_target(target), GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+            break;
+        case RENDER_TARGET_DEPTH_NONE:
+            break;
+    }
+    glBindTexture(texture_target(target), 0);
+    
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE || glGetError() != GL_NO_ERROR) {
+        fprintf(stderr, "Failed to create %dx%d render target (status 0x%x)\n", config->width, config->height, status);
+        return false;
+    }
+    return true;
+}
+
+RenderTargetConfig render_target_config_default(void) {
+    RenderTargetConfig config;
+    config.width = 1;
+    config.height = 1;
+    config.layers = 0;
+    config.samples = 0;
+    config.color = RENDER_TARGET_COLOR_RGBA8;
+    config.depth = RENDER_TARGET_DEPTH_BUFFER;
+    return config;
+}
+
+RenderTarget render_target_create(RenderTargetConfig config) {
+    if (config.width <= 0 || config.height <= 0 || config.layers < 0) {
+        fprintf(stderr, "Invalid render target size\n");
+        return NULL;
+    }
+    
+    // Samples live in renderbuffers, which have neither layers nor a depth texture
+    if (config.samples > 1) {
+        if (config.layers > 0 || config.depth == RENDER_TARGET_DEPTH_TEXTURE) {
+            fprintf(stderr, "Multisampled render targets cannot have layers or a depth texture\n");
+            return NULL;
+        }
+        int max_samples = 0;
+        glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+        if (max_samples > 0 && config.samples > max_samples) {
+            fprintf(stderr, "Using %d samples per pixel, the most supported\n", max_samples);
+            config.samples = max_samples;
+        }
+    } else {
+        config.samples = 0;
+    }
+    
+    RenderTarget target = (RenderTarget)calloc(1, sizeof(struct RenderTargetImpl));
+    if (!target) {
+        fprintf(stderr, "Failed to allocate render target\n");
+        return NULL;
+    }
+    target->config = config;
+    
+    glGenFramebuffers(1, &target->framebuffer);
+    if (!create_attachments(target)) {
+        render_target_destroy(target);
+        return NULL;
+    }
+    return target;
+}
+
+bool render_target_resize(RenderTarget target, int width, int height) {
+    if (!target || width <= 0 || height <= 0) return false;
+    if (width == target->config.width && height == target->config.height) return true;
+    
+    target->config.width = width;
+    target->config.height = height;
+    return create_attachments(target);
+}
+
+void render_target_bind(RenderTarget target, int layer) {
+    if (!target) return;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+    if (target->config.layers > 0 && layer != target->layer && layer >= 0 && layer < target->config.layers) {
+        if (target->color_texture) {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target->color_texture, 0, layer);
+        }
+        if (target->depth_texture) {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target->depth_texture, 0, layer);
+        }
+        target->layer = layer;
+    }
+    glViewport(0, 0, target->config.width, target->config.height);
+}
+
+void render_target_unbind(void) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void render_target_blit(RenderTarget source, const int* source_rect, RenderTarget destination,
+                        const int* destination_rect, bool linear) {
+    if (!source) return;
+    
+    // Blits are clipped by the scissor test like any other drawing
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source->framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination ? destination->framebuffer : 0);
+    glBlitFramebuffer(source_rect[0], source_rect[1], source_rect[0] + source_rect[2], source_rect[1] + source_rect[3],
+                      destination_rect[0], destination_rect[1],
+                      destination_rect[0] + destination_rect[2], destination_rect[1] + destination_rect[3],
+                      GL_COLOR_BUFFER_BIT, linear ? GL_LINEAR : GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    
+    if (scissor) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+}
+
+bool render_target_read_pixels(RenderTarget target, unsigned char* pixels) {
+    if (!target || !pixels || target->config.color != RENDER_TARGET_COLOR_RGBA8 ||
+        target->config.layers > 0 || target->config.samples > 1) return false;
+    
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target->framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, target->config.width, target->config.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    return true;
+}
+
+void render_target_get_size(RenderTarget target, int* width, int* height) {
+    *width = target ? target->config.width : 0;
+    *height = target ? target->config.height : 0;
+}
+
+int render_target_get_layers(RenderTarget target) {
+    return target ? target->config.layers : 0;
+}
+
+int render_target_get_samples(RenderTarget target) {
+    return target ? target->config.samples : 0;
+}
+
+unsigned int render_target_get_color_texture(RenderTarget target) {
+    return target ? target->color_texture : 0;
+}
+
+unsigned int render_target_get_depth_texture(RenderTarget target) {
+    return target ? target->depth_texture : 0;
+}
+
+size_t render_target_get_memory_size(RenderTarget target) {
+    if (!target) return 0;
+    
+    // Every format here takes four bytes per sample
+    size_t attachments = (target->color_texture || target->color_buffer ? 1 : 0) +
+                         (target->depth_texture || target->depth_buffer ? 1 : 0);
+    size_t layers = target->config.layers > 0 ? (size_t)target->config.layers : 1;
+    size_t samples = target->config.samples > 1 ? (size_t)target->config.samples : 1;
+    return attachments * layers * samples * (size_t)target->config.width * (size_t)target->config.height * 4;
+}
+
+void render_target_destroy(RenderTarget target) {
+    if (!target) return;
+    
+    release_attachments(target);
+    if (target->framebuffer) {
+        glDeleteFramebuffers(1, &target->framebuffer);
+    }
+    free(target);
+}
\ No newline at end of file
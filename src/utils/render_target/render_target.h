@@ -0,0 +1,87 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Color attachment of a render target
+typedef enum {
+    RENDER_TARGET_COLOR_NONE = 0,
+    RENDER_TARGET_COLOR_RGBA8,
+    RENDER_TARGET_COLOR_R32UI   // Unsigned integers, e.g. ids
+} RenderTargetColor;
+
+// Depth attachment of a render target
+typedef enum {
+    RENDER_TARGET_DEPTH_NONE = 0,
+    RENDER_TARGET_DEPTH_BUFFER,  // 24-bit renderbuffer, only for depth testing
+    RENDER_TARGET_DEPTH_TEXTURE  // 32-bit float texture sampled with depth comparison
+} RenderTargetDepth;
+
+// Render target configuration structure
+typedef struct {
+    int width;
+    int height;
+    int layers; // 0 for 2D textures, else 2D array textures with this many layers
+    int samples; // Samples per pixel (0 or 1 for none), kept in renderbuffers
+    RenderTargetColor color;
+    RenderTargetDepth depth;
+} RenderTargetConfig;
+
+// Opaque handle for a render target
+// A framebuffer object with its attachments. Framebuffer objects are not
+// shared between GL contexts, so a target may only be bound on the context
+// that created it; its textures can be read from any context.
+typedef struct RenderTargetImpl* RenderTarget;
+
+// Default render target configuration (RGBA8 color and a depth buffer)
+RenderTargetConfig render_target_config_default(void);
+
+// Create a render target; needs a current GL context
+// Returns NULL if the attachments cannot be allocated or combined.
+RenderTarget render_target_create(RenderTargetConfig config);
+
+// Reallocate the attachments at a new size, discarding their contents
+bool render_target_resize(RenderTarget target, int width, int height);
+
+// Draw into one layer of the target (0 for 2D targets) and set the viewport
+// to all of it. The depth buffer of a layered target is shared by its layers.
+void render_target_bind(RenderTarget target, int layer);
+
+// Draw into the current window again
+void render_target_unbind(void);
+
+// Copy the color of a rectangle (x, y, width, height) of one target into a
+// rectangle of another, or of the current window if destination is NULL,
+// resolving samples and scaling with nearest or linear filtering. A
+// multisampled source must be copied at the same size.
+void render_target_blit(RenderTarget source, const int* source_rect, RenderTarget destination,
+                        const int* destination_rect, bool linear);
+
+// Read the color of a 2D RGBA8 target that is not multisampled into
+// width * height * 4 bytes, bottom row first
+// Returns false for any other kind of target.
+bool render_target_read_pixels(RenderTarget target, unsigned char* pixels);
+
+// Get the size of the target
+void render_target_get_size(RenderTarget target, int* width, int* height);
+
+// Get the number of layers (0 for 2D targets)
+int render_target_get_layers(RenderTarget target);
+
+// Get the samples per pixel (0 unless multisampled)
+int render_target_get_samples(RenderTarget target);
+
+// Get the color texture (0 without one, or when multisampled)
+unsigned int render_target_get_color_texture(RenderTarget target);
+
+// Get the depth texture (0 unless the depth attachment is a texture)
+unsigned int render_target_get_depth_texture(RenderTarget target);
+
+// Get the GPU memory taken by the attachments, in bytes
+size_t render_target_get_memory_size(RenderTarget target);
+
+// Destroy the target on the context that created it
+void render_target_destroy(RenderTarget target);
+
+#endif /* RENDER_TARGET_H */
\ No newline at end of file
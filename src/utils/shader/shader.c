@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 
 // Include OpenGL headers
 #ifdef __APPLE__
@@ -11,7 +12,8 @@
 #endif
 
 // Helper function to check shader compilation/linking errors
-static void check_shader_errors(unsigned int shader, const char* type) {
+// Returns true if the shader compiled (or the program linked) successfully
+static bool check_shader_errors(unsigned int shader, const char* type) {
     int success;
     char info_log[1024];
     
@@ -28,6 +30,8 @@ static void check_shader_errors(unsigned int shader, const char* type) {
             printf("ERROR::SHADER::%s::COMPILATION_FAILED\n%s\n", type, info_log);
         }
     }
+    
+    return success != 0;
 }
 
 ShaderProgram shader_create_program(const char* vertex_shader_source, const char* fragment_shader_source) {
@@ -35,25 +39,74 @@ ShaderProgram shader_create_program(const char* vertex_shader_source, const char
     unsigned int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertex_shader, 1, &vertex_shader_source, NULL);
     glCompileShader(vertex_shader);
-    check_shader_errors(vertex_shader, "VERTEX");
+    bool ok = check_shader_errors(vertex_shader, "VERTEX");
     
     // Create fragment shader
     unsigned int fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragment_shader, 1, &fragment_shader_source, NULL);
     glCompileShader(fragment_shader);
-    check_shader_errors(fragment_shader, "FRAGMENT");
+    ok = check_shader_errors(fragment_shader, "FRAGMENT") && ok;
     
     // Create shader program
     ShaderProgram program = glCreateProgram();
     glAttachShader(program, vertex_shader);
     glAttachShader(program, fragment_shader);
     glLinkProgram(program);
-    check_shader_errors(program, "PROGRAM");
+    ok = check_shader_errors(program, "PROGRAM") && ok;
     
     // Delete shaders as they're linked into the program now and no longer necessary
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
     
+    // Never hand out a broken program
+    if (!ok) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    
+    return program;
+}
+
+char* shader_load_source(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open shader file: %s\n", path);
+        return NULL;
+    }
+    
+    // Determine the file size
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return NULL;
+    }
+    
+    // Read the whole file and null-terminate it
+    char* source = (char*)malloc((size_t)size + 1);
+    if (!source) {
+        fclose(file);
+        return NULL;
+    }
+    size_t read = fread(source, 1, (size_t)size, file);
+    source[read] = '\0';
+    fclose(file);
+    
+    return source;
+}
+
+ShaderProgram shader_create_program_from_files(const char* vertex_shader_path, const char* fragment_shader_path) {
+    char* vertex_source = shader_load_source(vertex_shader_path);
+    char* fragment_source = shader_load_source(fragment_shader_path);
+    
+    ShaderProgram program = 0;
+    if (vertex_source && fragment_source) {
+        program = shader_create_program(vertex_source, fragment_source);
+    }
+    
+    free(vertex_source);
+    free(fragment_source);
     return program;
 }
 
@@ -65,6 +118,17 @@ void shader_set_float(ShaderProgram program, const char* name, float value) {
     glUniform1f(glGetUniformLocation(program, name), value);
 }
 
+void shader_set_int(ShaderProgram program, const char* name, int value) {
+    glUniform1i(glGetUniformLocation(program, name), value);
+}
+
+void shader_bind_uniform_block(ShaderProgram program, const char* name, unsigned int binding) {
+    unsigned int index = glGetUniformBlockIndex(program, name);
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, index, binding);
+    }
+}
+
 void shader_set_mat4(ShaderProgram program, const char* name, const float* matrix) {
     glUniformMatrix4fv(glGetUniformLocation(program, name), 1, GL_FALSE, matrix);
 }
@@ -5,14 +5,29 @@
 typedef unsigned int ShaderProgram;
 
 // Create a shader program from vertex and fragment shader source
+// Returns 0 if compilation or linking fails
 ShaderProgram shader_create_program(const char* vertex_shader_source, const char* fragment_shader_source);
 
+// Read a shader source file into a newly allocated, null-terminated string
+// The caller owns the returned buffer; returns NULL on failure
+char* shader_load_source(const char* path);
+
+// Create a shader program from vertex and fragment shader files
+// Returns 0 if a file cannot be read or the program fails to build
+ShaderProgram shader_create_program_from_files(const char* vertex_shader_path, const char* fragment_shader_path);
+
 // Use a shader program
 void shader_use_program(ShaderProgram program);
 
 // Set a uniform float value in the shader
 void shader_set_float(ShaderProgram program, const char* name, float value);
 
+// Set a uniform int value (or sampler unit) in the shader
+void shader_set_int(ShaderProgram program, const char* name, int value);
+
+// Attach a uniform block of the shader to a uniform buffer binding point
+void shader_bind_uniform_block(ShaderProgram program, const char* name, unsigned int binding);
+
 // Set a uniform 4x4 matrix in the shader
 void shader_set_mat4(ShaderProgram program, const char* name, const float* matrix);
 
@@ -0,0 +1,406 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "shader_reload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Include OpenGL headers
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <glad/glad.h>
+#endif
+
+// How long the watcher blocks before re-checking whether it should stop
+#define RELOAD_POLL_INTERVAL_MS 250
+
+// Editors often save in several steps (truncate, write, rename); wait this
+// long after the first event so we compile the finished file only once
+#define RELOAD_DEBOUNCE_MS 50
+
+// Most programs one reloader watches
+#define RELOAD_MAX_PROGRAMS 8
+
+// A watched vertex/fragment shader pair
+typedef struct {
+    char* vertex_path;
+    char* fragment_path;
+    bool changed; // Only touched by the watcher thread
+    
+    // Program compiled in the background, waiting to be swapped in (guarded
+    // by the reloader's lock)
+    ShaderProgram pending_program;
+    GLsync pending_fence;
+
+#ifdef __linux__
+    int vertex_watch;
+    int fragment_watch;
+#else
+    time_t vertex_mtime;
+    time_t fragment_mtime;
+#endif
+} WatchedProgram;
+
+// Define the actual reloader implementation structure
+struct ShaderReloaderImpl {
+    // Hidden context owned by the watcher thread
+    Window context;
+    pthread_t thread;
+    atomic_bool running;
+    
+    // Programs are added under the lock; the watcher only looks at the
+    // published count, so it never sees one half set up
+    pthread_mutex_t lock;
+    WatchedProgram programs[RELOAD_MAX_PROGRAMS];
+    atomic_int program_count;
+
+#ifdef __linux__
+    int inotify_fd;
+#endif
+};
+
+static char* copy_string(const char* str) {
+    size_t length = strlen(str);
+    char* copy = (char*)malloc(length + 1);
+    if (copy) {
+        memcpy(copy, str, length + 1);
+    }
+    return copy;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+#ifdef __linux__
+
+// Return the file name part of a path
+static const char* path_basename(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+// Watch the directory rather than the file itself: editors that save by
+// renaming a temporary file over the original would otherwise drop the watch.
+// Directories shared by several files are watched once.
+static int watch_parent_directory(int fd, const char* path) {
+    char directory[1024];
+    const char* slash = strrchr(path, '/');
+    if (!slash) {
+        strcpy(directory, ".");
+    } else {
+        size_t length = (size_t)(slash - path);
+        if (length >= sizeof(directory)) return -1;
+        memcpy(directory, path, length);
+        directory[length] = '\0';
+    }
+    
+    return inotify_add_watch(fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+}
+
+static bool watcher_init(ShaderReloader reloader) {
+    reloader->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (reloader->inotify_fd < 0) {
+        fprintf(stderr, "Failed to initialize inotify\n");
+        return false;
+    }
+    return true;
+}
+
+static bool watcher_add(ShaderReloader reloader, WatchedProgram* watched) {
+    watched->vertex_watch = watch_parent_directory(reloader->inotify_fd, watched->vertex_path);
+    watched->fragment_watch = watch_parent_directory(reloader->inotify_fd, watched->fragment_path);
+    if (watched->vertex_watch < 0 || watched->fragment_watch < 0) {
+        fprintf(stderr, "Failed to watch shader directory\n");
+        return false;
+    }
+    return true;
+}
+
+// Read all queued events, flagging the programs they concern
+static bool watcher_drain(ShaderReloader reloader, int count) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t length;
+    
+    while ((length = read(reloader->inotify_fd, buffer, sizeof(buffer))) > 0) {
+        const struct inotify_event* event;
+        for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + event->len) {
+            event = (const struct inotify_event*)ptr;
+            if (event->len == 0) continue;
+            for (int i = 0; i < count; i++) {
+                WatchedProgram* watched = &reloader->programs[i];
+                if ((event->wd == watched->vertex_watch && strcmp(event->name, path_basename(watched->vertex_path)) == 0) ||
+                    (event->wd == watched->fragment_watch && strcmp(event->name, path_basename(watched->fragment_path)) == 0)) {
+                    watched->changed = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+    
+    return changed;
+}
+
+// Block until a shader file changes or the poll interval expires
+static bool watcher_wait(ShaderReloader reloader, int count) {
+    struct pollfd pfd;
+    pfd.fd = reloader->inotify_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    
+    if (poll(&pfd, 1, RELOAD_POLL_INTERVAL_MS) <= 0) {
+        return false;
+    }
+    if (!watcher_drain(reloader, count)) {
+        return false;
+    }
+    
+    sleep_ms(RELOAD_DEBOUNCE_MS);
+    watcher_drain(reloader, count);
+    return true;
+}
+
+static void watcher_terminate(ShaderReloader reloader) {
+    close(reloader->inotify_fd);
+}
+
+#else
+
+// Without inotify fall back to polling modification times
+static time_t file_mtime(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? info.st_mtime : 0;
+}
+
+static bool watcher_init(ShaderReloader reloader) {
+    (void)reloader;
+    return true;
+}
+
+static bool watcher_add(ShaderReloader reloader, WatchedProgram* watched) {
+    (void)reloader;
+    watched->vertex_mtime = file_mtime(watched->vertex_path);
+    watched->fragment_mtime = file_mtime(watched->fragment_path);
+    return true;
+}
+
+static bool watcher_wait(ShaderReloader reloader, int count) {
+    sleep_ms(RELOAD_POLL_INTERVAL_MS);
+    
+    bool changed = false;
+    for (int i = 0; i < count; i++) {
+        WatchedProgram* watched = &reloader->programs[i];
+        time_t vertex_mtime = file_mtime(watched->vertex_path);
+        time_t fragment_mtime = file_mtime(watched->fragment_path);
+        if (vertex_mtime != watched->vertex_mtime || fragment_mtime != watched->fragment_mtime) {
+            watched->vertex_mtime = vertex_mtime;
+            watched->fragment_mtime = fragment_mtime;
+            watched->changed = true;
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return false;
+    }
+    
+    sleep_ms(RELOAD_DEBOUNCE_MS);
+    return true;
+}
+
+static void watcher_terminate(ShaderReloader reloader) {
+    (void)reloader;
+}
+
+#endif
+
+// Drop a pending program that was never swapped in
+// Must be called with the lock held and a context current
+static void discard_pending(WatchedProgram* watched) {
+    if (watched->pending_program) {
+        glDeleteSync(watched->pending_fence);
+        shader_delete_program(watched->pending_program);
+        watched->pending_program = 0;
+        watched->pending_fence = NULL;
+    }
+}
+
+// Rebuild one program whose files changed and leave it to be swapped in
+static void recompile(ShaderReloader reloader, WatchedProgram* watched) {
+    printf("Recompiling shaders: %s, %s\n", watched->vertex_path, watched->fragment_path);
+    ShaderProgram program = shader_create_program_from_files(watched->vertex_path, watched->fragment_path);
+    if (!program) {
+        fprintf(stderr, "Shader reload failed, keeping the current program\n");
+        return;
+    }
+    
+    // The render thread may only use the program once the driver has
+    // actually finished building it on this context
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    
+    pthread_mutex_lock(&reloader->lock);
+    discard_pending(watched);
+    watched->pending_program = program;
+    watched->pending_fence = fence;
+    pthread_mutex_unlock(&reloader->lock);
+}
+
+static void* reload_thread(void* arg) {
+    ShaderReloader reloader = (ShaderReloader)arg;
+    window_make_context_current(reloader->context);
+    
+    while (atomic_load(&reloader->running)) {
+        int count = atomic_load_explicit(&reloader->program_count, memory_order_acquire);
+        if (!watcher_wait(reloader, count)) {
+            continue;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            WatchedProgram* watched = &reloader->programs[i];
+            if (watched->changed) {
+                watched->changed = false;
+                recompile(reloader, watched);
+            }
+        }
+    }
+    
+    pthread_mutex_lock(&reloader->lock);
+    int count = atomic_load(&reloader->program_count);
+    for (int i = 0; i < count; i++) {
+        discard_pending(&reloader->programs[i]);
+    }
+    pthread_mutex_unlock(&reloader->lock);
+    
+    window_make_context_current(NULL);
+    return NULL;
+}
+
+ShaderReloader shader_reloader_create(Window window) {
+    ShaderReloader reloader = (ShaderReloader)calloc(1, sizeof(struct ShaderReloaderImpl));
+    if (!reloader) {
+        fprintf(stderr, "Failed to allocate shader reloader\n");
+        return NULL;
+    }
+    if (!watcher_init(reloader)) {
+        free(reloader);
+        return NULL;
+    }
+    
+    // Creating the context must happen here, on the main thread; only making
+    // it current is done by the watcher
+    reloader->context = window_create_shared_context(window);
+    if (!reloader->context) {
+        watcher_terminate(reloader);
+        free(reloader);
+        return NULL;
+    }
+    
+    // Creating a window may have switched the current context
+    window_make_context_current(window);
+    
+    pthread_mutex_init(&reloader->lock, NULL);
+    atomic_init(&reloader->program_count, 0);
+    atomic_store(&reloader->running, true);
+    if (pthread_create(&reloader->thread, NULL, reload_thread, reloader) != 0) {
+        fprintf(stderr, "Failed to start shader reload thread\n");
+        pthread_mutex_destroy(&reloader->lock);
+        window_destroy_shared(reloader->context);
+        watcher_terminate(reloader);
+        free(reloader);
+        return NULL;
+    }
+    
+    return reloader;
+}
+
+int shader_reloader_add_program(ShaderReloader reloader, const char* vertex_shader_path,
+                                const char* fragment_shader_path) {
+    if (!reloader) return -1;
+    
+    pthread_mutex_lock(&reloader->lock);
+    int id = atomic_load_explicit(&reloader->program_count, memory_order_relaxed);
+    if (id == RELOAD_MAX_PROGRAMS) {
+        pthread_mutex_unlock(&reloader->lock);
+        fprintf(stderr, "Too many shader programs to watch\n");
+        return -1;
+    }
+    
+    WatchedProgram* watched = &reloader->programs[id];
+    watched->vertex_path = copy_string(vertex_shader_path);
+    watched->fragment_path = copy_string(fragment_shader_path);
+    if (!watched->vertex_path || !watched->fragment_path || !watcher_add(reloader, watched)) {
+        free(watched->vertex_path);
+        free(watched->fragment_path);
+        memset(watched, 0, sizeof(*watched));
+        pthread_mutex_unlock(&reloader->lock);
+        return -1;
+    }
+    
+    atomic_store_explicit(&reloader->program_count, id + 1, memory_order_release);
+    pthread_mutex_unlock(&reloader->lock);
+    return id;
+}
+
+bool shader_reloader_poll(ShaderReloader reloader, int id, ShaderProgram* program) {
+    if (!reloader || !program || id < 0 || id >= atomic_load(&reloader->program_count)) return false;
+    
+    // Never stall the frame on the watcher thread
+    if (pthread_mutex_trylock(&reloader->lock) != 0) {
+        return false;
+    }
+    
+    bool swapped = false;
+    WatchedProgram* watched = &reloader->programs[id];
+    if (watched->pending_program) {
+        // Leave the program pending until the build has completed
+        GLenum status = glClientWaitSync(watched->pending_fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            glDeleteSync(watched->pending_fence);
+            shader_delete_program(*program);
+            *program = watched->pending_program;
+            watched->pending_program = 0;
+            watched->pending_fence = NULL;
+            swapped = true;
+        }
+    }
+    
+    pthread_mutex_unlock(&reloader->lock);
+    
+    if (swapped) {
+        printf("Shader program reloaded\n");
+    }
+    return swapped;
+}
+
+void shader_reloader_destroy(ShaderReloader reloader) {
+    if (!reloader) return;
+    
+    atomic_store(&reloader->running, false);
+    pthread_join(reloader->thread, NULL);
+    
+    pthread_mutex_destroy(&reloader->lock);
+    window_destroy_shared(reloader->context);
+    watcher_terminate(reloader);
+    int count = atomic_load(&reloader->program_count);
+    for (int i = 0; i < count; i++) {
+        free(reloader->programs[i].vertex_path);
+        free(reloader->programs[i].fragment_path);
+    }
+    free(reloader);
+}
@@ -0,0 +1,32 @@
+#ifndef SHADER_RELOAD_H
+#define SHADER_RELOAD_H
+
+#include <stdbool.h>
+#include "shader.h"
+#include "../../window/window.h"
+
+// Opaque handle for a shader hot-reloader
+// One background thread watches the files of every program added to it and
+// recompiles the programs whose files change on a hidden GL context that
+// shares objects with the main window
+typedef struct ShaderReloaderImpl* ShaderReloader;
+
+// Start the watcher thread; programs are added to it afterwards
+// The window must be the one whose context renders with the programs
+ShaderReloader shader_reloader_create(Window window);
+
+// Watch a vertex/fragment shader pair, from any thread
+// Returns the id to poll the program with, or -1 if it cannot be watched.
+int shader_reloader_add_program(ShaderReloader reloader, const char* vertex_shader_path,
+                                const char* fragment_shader_path);
+
+// Swap in a freshly compiled version of a program, if one is ready
+// Call at a frame boundary on the render thread. On success the old program
+// is deleted, *program is replaced and true is returned. Failed builds never
+// reach this point, so the current program stays in use.
+bool shader_reloader_poll(ShaderReloader reloader, int id, ShaderProgram* program);
+
+// Stop the watcher thread and release its resources
+void shader_reloader_destroy(ShaderReloader reloader);
+
+#endif /* SHADER_RELOAD_H */
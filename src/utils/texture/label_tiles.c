@@ -0,0 +1,107 @@
+#include "label_tiles.h"
+#include <stdio.h>
+#include <math.h>
+
+// 3x5 digit glyphs, one bit per cell, top row first
+static const unsigned short digit_glyphs[10] = {
+    0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF
+};
+
+// Shade of the label of one layer at (u, v), v pointing up
+static void paint_label(int layer, float u, float v, const float* tint, float* color) {
+    float shade = 1.0f;
+    
+    // Fine grid, only resolved at the finest levels
+    float grid_u = u * 32.0f - floorf(u * 32.0f);
+    float grid_v = v * 32.0f - floorf(v * 32.0f);
+    if (grid_u < 0.08f || grid_v < 0.08f) {
+        shade = 0.75f;
+    }
+    
+    // Frame around the panel
+    if (u < 0.04f || u > 0.96f || v < 0.04f || v > 0.96f) {
+        shade = 0.35f;
+    }
+    
+    // The layer number, centered in large digits
+    int digits[4], digit_count = 0;
+    int number = layer;
+    do {
+        digits[digit_count++] = number % 10;
+        number /= 10;
+    } while (number > 0 && digit_count < 4);
+    
+    float cell = 0.6f / (float)(digit_count * 4 - 1) < 0.12f ? 0.6f / (float)(digit_count * 4 - 1) : 0.12f;
+    float left = 0.5f - cell * (float)(digit_count * 4 - 1) * 0.5f;
+    float top = 0.5f + cell * 2.5f;
+    int column = (int)floorf((u - left) / cell);
+    int row = (int)floorf((top - v) / cell);
+    if (u >= left && v <= top && column < digit_count * 4 - 1 && row < 5 && column % 4 != 3) {
+        int glyph = digit_glyphs[digits[digit_count - 1 - column / 4]];
+        if (glyph & (1 << (14 - (row * 3 + column % 4)))) {
+            shade = 0.12f;
+        }
+    }
+    
+    for (int c = 0; c < 3; c++) {
+        color[c] = shade * tint[c];
+    }
+}
+
+// Paint one page: each texel averages 2x2 samples of the label
+static void paint_page(void* context, const TileFileInfo* info, int layer, int level, int x, int y, unsigned char* rgba) {
+    (void)context;
+    int content = info->page_size - 2 * info->border;
+    int size = (info->pages >> level) * content;
+    
+    // A light tint per layer, spread around the color wheel
+    float hue = (float)layer * 0.618034f;
+    hue -= floorf(hue);
+    float tint[3];
+    for (int c = 0; c < 3; c++) {
+        float distance = fabsf(hue * 3.0f - (float)c);
+        distance = fminf(distance, 3.0f - distance);
+        tint[c] = 0.8f + 0.2f * fmaxf(0.0f, 1.0f - distance);
+    }
+    
+    for (int ty = 0; ty < info->page_size; ty++) {
+        for (int tx = 0; tx < info->page_size; tx++) {
+            // Border texels repeat the neighbouring pages, clamped at the edges
+            int vx = x * content + tx - info->border;
+            int vy = y * content + ty - info->border;
+            vx = vx < 0 ? 0 : (vx > size - 1 ? size - 1 : vx);
+            vy = vy < 0 ? 0 : (vy > size - 1 ? size - 1 : vy);
+            
+            float sum[3] = { 0.0f, 0.0f, 0.0f };
+            for (int s = 0; s < 4; s++) {
+                float color[3];
+                float u = ((float)vx + 0.25f + 0.5f * (float)(s & 1)) / (float)size;
+                float v = ((float)vy + 0.25f + 0.5f * (float)(s >> 1)) / (float)size;
+                paint_label(layer, u, v, tint, color);
+                for (int c = 0; c < 3; c++) {
+                    sum[c] += color[c];
+                }
+            }
+            
+            unsigned char* texel = rgba + ((size_t)ty * info->page_size + tx) * 4;
+            for (int c = 0; c < 3; c++) {
+                texel[c] = (unsigned char)(sum[c] * 0.25f * 255.0f + 0.5f);
+            }
+            texel[3] = 255;
+        }
+    }
+}
+
+bool label_tiles_write(const char* path, TextureFormat format, int layer_count, int pages, ThreadPool pool) {
+    TileFileInfo info;
+    info.format = format;
+    info.page_size = LABEL_TILES_PAGE_SIZE;
+    info.border = LABEL_TILES_BORDER;
+    info.layer_count = layer_count;
+    info.pages = pages;
+    info.level_count = 0;
+    
+    printf("Writing %d %s labels of %dx%d texels to %s\n", layer_count, texture_format_get_name(format),
+           pages * (LABEL_TILES_PAGE_SIZE - 2 * LABEL_TILES_BORDER), pages * (LABEL_TILES_PAGE_SIZE - 2 * LABEL_TILES_BORDER), path);
+    return tile_file_write(path, &info, paint_page, NULL, pool);
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef LABEL_TILES_H
+#define LABEL_TILES_H
+
+#include <stdbool.h>
+#include "tile_file.h"
+
+// Default layout of the generated cube face labels
+#define LABEL_TILES_PAGE_SIZE 128
+#define LABEL_TILES_BORDER 4
+#define LABEL_TILES_LAYERS 64
+#define LABEL_TILES_PAGES 16
+
+// Write a tile file of numbered face labels, one per layer
+// Each label is a tinted panel with a fine grid and the layer number in
+// large digits; every level is painted directly at its own resolution.
+bool label_tiles_write(const char* path, TextureFormat format, int layer_count, int pages, ThreadPool pool);
+
+#endif /* LABEL_TILES_H */
\ No newline at end of file
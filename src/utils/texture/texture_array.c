@@ -0,0 +1,190 @@
+#include "texture_array.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <glad/glad.h>
+#endif
+
+// Compressed formats are extensions on some platforms
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+
+// How each format is stored and where it comes from
+typedef struct {
+    const char* name;
+    unsigned int internal_format;
+    int block_bytes;       // Bytes per 4x4 block, 0 for uncompressed formats
+    const char* extension; // Extension providing the format, if any
+    int core_version;      // GL version (major * 10 + minor) it became core in, 0 if never
+} FormatInfo;
+
+static const FormatInfo formats[TEXTURE_FORMAT_COUNT] = {
+    { "rgba8", GL_RGBA8, 0, NULL, 30 },
+    { "bc1", GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 8, "GL_EXT_texture_compression_s3tc", 0 },
+    { "bc7", GL_COMPRESSED_RGBA_BPTC_UNORM, 16, "GL_ARB_texture_compression_bptc", 42 },
+    { "etc2", GL_COMPRESSED_RGB8_ETC2, 8, "GL_ARB_ES3_compatibility", 43 },
+};
+
+// Define the actual texture array implementation structure
+struct TextureArrayImpl {
+    unsigned int texture;
+    TextureFormat format;
+    int width;
+    int height;
+    int layers;
+    int levels;
+};
+
+const char* texture_format_get_name(TextureFormat format) {
+    if (format < 0 || format >= TEXTURE_FORMAT_COUNT) return "unknown";
+    return formats[format].name;
+}
+
+bool texture_format_from_name(const char* name, TextureFormat* format) {
+    for (int i = 0; i < TEXTURE_FORMAT_COUNT; i++) {
+        if (strcmp(name, formats[i].name) == 0) {
+            *format = (TextureFormat)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t texture_format_get_image_size(TextureFormat format, int width, int height) {
+    if (format < 0 || format >= TEXTURE_FORMAT_COUNT) return 0;
+    
+    if (formats[format].block_bytes == 0) {
+        return (size_t)width * (size_t)height * 4;
+    }
+    size_t blocks_x = (size_t)(width + 3) / 4;
+    size_t blocks_y = (size_t)(height + 3) / 4;
+    return blocks_x * blocks_y * (size_t)formats[format].block_bytes;
+}
+
+bool texture_format_is_supported(TextureFormat format) {
+    if (format < 0 || format >= TEXTURE_FORMAT_COUNT) return false;
+    const FormatInfo* info = &formats[format];
+    
+    int major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (info->core_version > 0 && major * 10 + minor >= info->core_version) {
+        return true;
+    }
+    if (!info->extension) {
+        return false;
+    }
+    
+    int extension_count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+    for (int i = 0; i < extension_count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (unsigned int)i);
+        if (extension && strcmp(extension, info->extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TextureArray texture_array_create(TextureFormat format, int width, int height, int layers, int levels) {
+    if (!texture_format_is_supported(format)) {
+        fprintf(stderr, "Texture format %s is not supported by this GL implementation\n", texture_format_get_name(format));
+        return NULL;
+    }
+    if (width <= 0 || height <= 0 || layers <= 0 || levels <= 0) {
+        fprintf(stderr, "Invalid texture array size\n");
+        return NULL;
+    }
+    
+    TextureArray array = (TextureArray)calloc(1, sizeof(struct TextureArrayImpl));
+    if (!array) {
+        fprintf(stderr, "Failed to allocate texture array\n");
+        return NULL;
+    }
+    array->format = format;
+    array->width = width;
+    array->height = height;
+    array->layers = layers;
+    array->levels = levels;
+    
+    // Start from a clean error state so failures below are ours
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    
+    glGenTextures(1, &array->texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array->texture);
+    
+    // Allocate every level; compressed levels are allocated without data
+    const FormatInfo* info = &formats[format];
+    for (int level = 0; level < levels; level++) {
+        int level_width = width >> level > 0 ? width >> level : 1;
+        int level_height = height >> level > 0 ? height >> level : 1;
+        if (info->block_bytes == 0) {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, (int)info->internal_format, level_width, level_height, layers,
+                         0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        } else {
+            size_t size = texture_format_get_image_size(format, level_width, level_height) * (size_t)layers;
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, info->internal_format, level_width, level_height, layers,
+                                   0, (int)size, NULL);
+        }
+    }
+    
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    
+    if (glGetError() != GL_NO_ERROR) {
+        fprintf(stderr, "Failed to allocate %dx%dx%d %s texture array\n", width, height, layers, info->name);
+        texture_array_destroy(array);
+        return NULL;
+    }
+    
+    return array;
+}
+
+bool texture_array_upload(TextureArray array, int level, int layer, int x, int y, int width, int height, const void* data) {
+    if (!array || !data) return false;
+    if (level < 0 || level >= array->levels || layer < 0 || layer >= array->layers) return false;
+    
+    const FormatInfo* info = &formats[array->format];
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array->texture);
+    if (info->block_bytes == 0) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    } else {
+        size_t size = texture_format_get_image_size(array->format, width, height);
+        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, width, height, 1,
+                                  info->internal_format, (int)size, data);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return true;
+}
+
+unsigned int texture_array_get_texture(TextureArray array) {
+    return array ? array->texture : 0;
+}
+
+int texture_array_get_layers(TextureArray array) {
+    return array ? array->layers : 0;
+}
+
+void texture_array_destroy(TextureArray array) {
+    if (!array) return;
+    
+    glDeleteTextures(1, &array->texture);
+    free(array);
+}
\ No newline at end of file
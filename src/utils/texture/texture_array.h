@@ -0,0 +1,48 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Texel formats; block-compressed data is uploaded as is, never decoded
+typedef enum {
+    TEXTURE_FORMAT_RGBA8 = 0,
+    TEXTURE_FORMAT_BC1 = 1,  // S3TC DXT1, 8 bytes per 4x4 block
+    TEXTURE_FORMAT_BC7 = 2,  // BPTC, 16 bytes per 4x4 block
+    TEXTURE_FORMAT_ETC2 = 3, // ETC2 RGB, 8 bytes per 4x4 block
+    TEXTURE_FORMAT_COUNT
+} TextureFormat;
+
+// Short lowercase name of a format, e.g. "bc1"
+const char* texture_format_get_name(TextureFormat format);
+
+// Look a format up by its short name
+bool texture_format_from_name(const char* name, TextureFormat* format);
+
+// Size in bytes of a width x height image
+size_t texture_format_get_image_size(TextureFormat format, int width, int height);
+
+// Check whether the current GL context can sample the format
+bool texture_format_is_supported(TextureFormat format);
+
+// Opaque handle for a 2D array texture
+typedef struct TextureArrayImpl* TextureArray;
+
+// Create an array of layers images of width x height with levels mip levels
+// Needs a current GL context. Returns NULL if the format is unsupported.
+TextureArray texture_array_create(TextureFormat format, int width, int height, int layers, int levels);
+
+// Replace a rectangle of one layer and level with data in the array's format
+// Compressed rectangles must start and end on 4x4 block boundaries.
+bool texture_array_upload(TextureArray array, int level, int layer, int x, int y, int width, int height, const void* data);
+
+// Get the GL texture object
+unsigned int texture_array_get_texture(TextureArray array);
+
+// Get the number of layers
+int texture_array_get_layers(TextureArray array);
+
+// Destroy the texture array
+void texture_array_destroy(TextureArray array);
+
+#endif /* TEXTURE_ARRAY_H */
\ No newline at end of file
@@ -0,0 +1,358 @@
+#include "tile_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// File layout: a header of little-endian 32-bit words, then the encoded
+// pages back to back in page number order
+#define TILE_FILE_MAGIC 0x54425543u // "CUBT"
+#define TILE_FILE_VERSION 1u
+#define TILE_FILE_HEADER_WORDS 8
+#define TILE_FILE_HEADER_SIZE (TILE_FILE_HEADER_WORDS * 4)
+
+// Pages painted and encoded per batch while writing
+#define TILE_FILE_WRITE_BATCH 64
+
+// Define the actual tile file implementation structure
+struct TileFileImpl {
+    TileFileInfo info;
+    size_t page_bytes;
+    int page_count;
+    const unsigned char* data; // Mapping of the whole file
+    size_t size;
+};
+
+// State shared by the painting tasks of one batch
+typedef struct {
+    const TileFileInfo* info;
+    TilePainter painter;
+    void* context;
+    int first_page;
+    size_t page_bytes;
+    unsigned char* output;
+    atomic_bool failed; // Set when a task could not produce its pages
+} WriteBatch;
+
+// Pages per side of a level
+static int level_pages(const TileFileInfo* info, int level) {
+    int pages = info->pages >> level;
+    return pages > 0 ? pages : 1;
+}
+
+// Pages in all levels of one layer
+static int layer_page_count(const TileFileInfo* info) {
+    int count = 0;
+    for (int level = 0; level < info->level_count; level++) {
+        count += level_pages(info, level) * level_pages(info, level);
+    }
+    return count;
+}
+
+// Check that the layout is one this module (and the shaders) can handle
+static bool validate_info(TileFileInfo* info) {
+    if (info->format < 0 || info->format >= TEXTURE_FORMAT_COUNT) return false;
+    if (info->pages < 1 || info->pages > TILE_FILE_MAX_PAGES || (info->pages & (info->pages - 1)) != 0) return false;
+    if (info->layer_count < 1 || info->layer_count > TILE_FILE_MAX_LAYERS) return false;
+    if (info->page_size < 4 || info->page_size % 4 != 0) return false;
+    if (info->border < 0 || info->border * 2 >= info->page_size) return false;
+    
+    // Only now is pages known to be a small power of two
+    int level_count = 1;
+    while ((1 << (level_count - 1)) < info->pages) {
+        level_count++;
+    }
+    info->level_count = level_count;
+    return true;
+}
+
+int tile_file_get_page_number(const TileFileInfo* info, int layer, int level, int x, int y) {
+    int page = layer * layer_page_count(info);
+    for (int l = 0; l < level; l++) {
+        page += level_pages(info, l) * level_pages(info, l);
+    }
+    return page + y * level_pages(info, level) + x;
+}
+
+void tile_file_get_page_location(const TileFileInfo* info, int page, int* layer, int* level, int* x, int* y) {
+    int per_layer = layer_page_count(info);
+    *layer = page / per_layer;
+    page %= per_layer;
+    
+    int l = 0;
+    while (page >= level_pages(info, l) * level_pages(info, l)) {
+        page -= level_pages(info, l) * level_pages(info, l);
+        l++;
+    }
+    *level = l;
+    *x = page % level_pages(info, l);
+    *y = page / level_pages(info, l);
+}
+
+// Pack a color into RGB565
+static uint16_t pack_565(const int* color) {
+    return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+// Expand an RGB565 color back to 8 bits per channel
+static void unpack_565(uint16_t packed, int* color) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Encode one 4x4 block of RGBA8 texels as BC1
+// Endpoints span the block's color bounding box, pulled in slightly, and
+// every texel takes the nearest of the four palette colors.
+static void encode_bc1_block(const unsigned char* rgba, int stride, unsigned char* block) {
+    int low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            const unsigned char* texel = rgba + y * stride + x * 4;
+            for (int c = 0; c < 3; c++) {
+                if (texel[c] < low[c]) low[c] = texel[c];
+                if (texel[c] > high[c]) high[c] = texel[c];
+            }
+        }
+    }
+    for (int c = 0; c < 3; c++) {
+        int inset = (high[c] - low[c]) / 16;
+        low[c] += inset;
+        high[c] -= inset;
+    }
+    
+    // Four-color mode needs the first endpoint to be the larger one
+    uint16_t color0 = pack_565(high), color1 = pack_565(low);
+    if (color0 < color1) {
+        uint16_t swap = color0;
+        color0 = color1;
+        color1 = swap;
+    }
+    
+    int palette[4][3];
+    unpack_565(color0, palette[0]);
+    unpack_565(color1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        for (int i = 15; i >= 0; i--) {
+            const unsigned char* texel = rgba + (i / 4) * stride + (i % 4) * 4;
+            int best = 0, best_error = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int error = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = texel[c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < best_error) {
+                    best_error = error;
+                    best = p;
+                }
+            }
+            indices = (indices << 2) | (uint32_t)best;
+        }
+    }
+    
+    block[0] = (unsigned char)(color0 & 0xFF);
+    block[1] = (unsigned char)(color0 >> 8);
+    block[2] = (unsigned char)(color1 & 0xFF);
+    block[3] = (unsigned char)(color1 >> 8);
+    for (int i = 0; i < 4; i++) {
+        block[4 + i] = (unsigned char)(indices >> (i * 8));
+    }
+}
+
+// Paint and encode pages [begin, end) of a batch
+static void write_pages(void* context, int begin, int end) {
+    WriteBatch* batch = (WriteBatch*)context;
+    const TileFileInfo* info = batch->info;
+    int size = info->page_size;
+    unsigned char* rgba = (unsigned char*)malloc((size_t)size * (size_t)size * 4);
+    if (!rgba) {
+        atomic_store(&batch->failed, true);
+        return;
+    }
+    
+    for (int i = begin; i < end; i++) {
+        int layer, level, x, y;
+        tile_file_get_page_location(info, batch->first_page + i, &layer, &level, &x, &y);
+        batch->painter(batch->context, info, layer, level, x, y, rgba);
+        
+        unsigned char* output = batch->output + (size_t)i * batch->page_bytes;
+        if (info->format == TEXTURE_FORMAT_RGBA8) {
+            memcpy(output, rgba, batch->page_bytes);
+            continue;
+        }
+        for (int by = 0; by < size / 4; by++) {
+            for (int bx = 0; bx < size / 4; bx++) {
+                encode_bc1_block(rgba + ((size_t)by * 4 * size + (size_t)bx * 4) * 4, size * 4,
+                                 output + ((size_t)by * (size / 4) + bx) * 8);
+            }
+        }
+    }
+    
+    free(rgba);
+}
+
+bool tile_file_write(const char* path, const TileFileInfo* info, TilePainter painter, void* context, ThreadPool pool) {
+    TileFileInfo layout = *info;
+    if (!validate_info(&layout)) {
+        fprintf(stderr, "Invalid tile file layout\n");
+        return false;
+    }
+    if (layout.format != TEXTURE_FORMAT_RGBA8 && layout.format != TEXTURE_FORMAT_BC1) {
+        fprintf(stderr, "Cannot encode %s tiles; only rgba8 and bc1 are supported\n", texture_format_get_name(layout.format));
+        return false;
+    }
+    
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to create tile file: %s\n", path);
+        return false;
+    }
+    
+    uint32_t header[TILE_FILE_HEADER_WORDS] = {
+        TILE_FILE_MAGIC, TILE_FILE_VERSION, (uint32_t)layout.format, (uint32_t)layout.page_size,
+        (uint32_t)layout.border, (uint32_t)layout.layer_count, (uint32_t)layout.pages, 0
+    };
+    unsigned char bytes[TILE_FILE_HEADER_SIZE];
+    for (int i = 0; i < TILE_FILE_HEADER_WORDS; i++) {
+        for (int b = 0; b < 4; b++) {
+            bytes[i * 4 + b] = (unsigned char)(header[i] >> (b * 8));
+        }
+    }
+    bool ok = fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+    
+    WriteBatch batch;
+    batch.info = &layout;
+    batch.painter = painter;
+    batch.context = context;
+    batch.page_bytes = texture_format_get_image_size(layout.format, layout.page_size, layout.page_size);
+    batch.output = (unsigned char*)malloc(batch.page_bytes * TILE_FILE_WRITE_BATCH);
+    atomic_init(&batch.failed, false);
+    ok = ok && batch.output;
+    
+    int page_count = layout.layer_count * layer_page_count(&layout);
+    for (int first = 0; ok && first < page_count; first += TILE_FILE_WRITE_BATCH) {
+        int count = page_count - first < TILE_FILE_WRITE_BATCH ? page_count - first : TILE_FILE_WRITE_BATCH;
+        batch.first_page = first;
+        thread_pool_parallel_for(pool, count, 1, write_pages, &batch);
+        ok = !atomic_load(&batch.failed) &&
+             fwrite(batch.output, batch.page_bytes, (size_t)count, file) == (size_t)count;
+    }
+    
+    free(batch.output);
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        // Leave no partial file behind to be loaded later
+        fprintf(stderr, "Failed to write tile file: %s\n", path);
+        remove(path);
+    }
+    return ok;
+}
+
+TileFile tile_file_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open tile file: %s\n", path);
+        return NULL;
+    }
+    
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (size_t)status.st_size < TILE_FILE_HEADER_SIZE) {
+        fprintf(stderr, "Not a tile file: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+    
+    // The mapping stays valid after the descriptor is closed
+    size_t size = (size_t)status.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Failed to map tile file: %s\n", path);
+        return NULL;
+    }
+    
+    // Pages are read in whatever order the feedback asks for them
+    madvise(data, size, MADV_RANDOM);
+    
+    uint32_t header[TILE_FILE_HEADER_WORDS];
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (int i = 0; i < TILE_FILE_HEADER_WORDS; i++) {
+        header[i] = (uint32_t)bytes[i * 4] | (uint32_t)bytes[i * 4 + 1] << 8 |
+                    (uint32_t)bytes[i * 4 + 2] << 16 | (uint32_t)bytes[i * 4 + 3] << 24;
+    }
+    
+    TileFileInfo info;
+    info.format = (TextureFormat)header[2];
+    info.page_size = (int)header[3];
+    info.border = (int)header[4];
+    info.layer_count = (int)header[5];
+    info.pages = (int)header[6];
+    if (header[0] != TILE_FILE_MAGIC || header[1] != TILE_FILE_VERSION || header[2] >= TEXTURE_FORMAT_COUNT ||
+        !validate_info(&info)) {
+        fprintf(stderr, "Not a tile file: %s\n", path);
+        munmap(data, size);
+        return NULL;
+    }
+    
+    size_t page_bytes = texture_format_get_image_size(info.format, info.page_size, info.page_size);
+    int page_count = info.layer_count * layer_page_count(&info);
+    if (size < TILE_FILE_HEADER_SIZE + page_bytes * (size_t)page_count) {
+        fprintf(stderr, "Tile file is truncated: %s\n", path);
+        munmap(data, size);
+        return NULL;
+    }
+    
+    TileFile file = (TileFile)calloc(1, sizeof(struct TileFileImpl));
+    if (!file) {
+        fprintf(stderr, "Failed to allocate tile file\n");
+        munmap(data, size);
+        return NULL;
+    }
+    file->info = info;
+    file->page_bytes = page_bytes;
+    file->page_count = page_count;
+    file->data = (const unsigned char*)data;
+    file->size = size;
+    return file;
+}
+
+const TileFileInfo* tile_file_get_info(TileFile file) {
+    return file ? &file->info : NULL;
+}
+
+size_t tile_file_get_page_bytes(TileFile file) {
+    return file ? file->page_bytes : 0;
+}
+
+int tile_file_get_page_count(TileFile file) {
+    return file ? file->page_count : 0;
+}
+
+bool tile_file_read_page(TileFile file, int page, void* data) {
+    if (!file || page < 0 || page >= file->page_count) return false;
+    
+    memcpy(data, file->data + TILE_FILE_HEADER_SIZE + (size_t)page * file->page_bytes, file->page_bytes);
+    return true;
+}
+
+void tile_file_close(TileFile file) {
+    if (!file) return;
+    
+    munmap((void*)file->data, file->size);
+    free(file);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef TILE_FILE_H
+#define TILE_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "texture_array.h"
+#include "../thread/thread_pool.h"
+
+// Layout of a tile file: a set of square texture layers, each with a full
+// mip chain cut into pages of page_size x page_size texels. Every page
+// repeats border texels of its neighbours on each side so it can be
+// filtered on its own; the rest of the page is its share of the image.
+typedef struct {
+    TextureFormat format;
+    int page_size;   // Texels per side of a page, border included
+    int border;      // Texels per side borrowed from the neighbouring pages
+    int layer_count; // Number of textures
+    int pages;       // Pages per side of level 0, a power of two
+    int level_count; // Levels down to a single page
+} TileFileInfo;
+
+// Largest sizes a tile file may have
+#define TILE_FILE_MAX_LAYERS 4096
+#define TILE_FILE_MAX_PAGES 256
+
+// Opaque handle for a memory-mapped tile file
+typedef struct TileFileImpl* TileFile;
+
+// Callback producing the RGBA8 texels of one page, border included, row by
+// row from the bottom; called from several threads at once
+typedef void (*TilePainter)(void* context, const TileFileInfo* info, int layer, int level, int x, int y,
+                            unsigned char* rgba);
+
+// Paint every page of a tile file and write it to path
+// Pages are encoded in info->format; only RGBA8 and BC1 can be encoded.
+// level_count is derived from pages. Work is spread over the pool.
+bool tile_file_write(const char* path, const TileFileInfo* info, TilePainter painter, void* context, ThreadPool pool);
+
+// Open and map a tile file
+TileFile tile_file_open(const char* path);
+
+// Get the layout of the file
+const TileFileInfo* tile_file_get_info(TileFile file);
+
+// Size of one encoded page in bytes
+size_t tile_file_get_page_bytes(TileFile file);
+
+// Number of pages in the file
+int tile_file_get_page_count(TileFile file);
+
+// Number of a page; pages are stored layer by layer, then level by level
+// from the finest, then row by row
+int tile_file_get_page_number(const TileFileInfo* info, int layer, int level, int x, int y);
+
+// Inverse of tile_file_get_page_number
+void tile_file_get_page_location(const TileFileInfo* info, int page, int* layer, int* level, int* x, int* y);
+
+// Copy one encoded page out of the file; touching the mapping may block on disk
+bool tile_file_read_page(TileFile file, int page, void* data);
+
+// Unmap and close the file
+void tile_file_close(TileFile file);
+
+#endif /* TILE_FILE_H */
\ No newline at end of file
@@ -0,0 +1,562 @@
+#include "virtual_texture.h"
+#include "texture_array.h"
+#include "../render_target/render_target.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <glad/glad.h>
+#endif
+
+// Pages that may be queued or read ahead of their upload
+#define VIRTUAL_TEXTURE_MAX_LOADS 64
+
+// Most pages uploaded per frame, to bound the time spent in an update
+#define VIRTUAL_TEXTURE_UPLOADS_PER_FRAME 32
+
+// Feedback readbacks in flight; the oldest finished one is used
+#define VIRTUAL_TEXTURE_FEEDBACK_BUFFERS 3
+
+// How long a synchronous update waits for the feedback, in nanoseconds
+#define VIRTUAL_TEXTURE_FEEDBACK_TIMEOUT 1000000000ull
+
+// Progress of one page through the loader
+typedef enum {
+    LOAD_FREE,
+    LOAD_QUEUED,
+    LOAD_READING,
+    LOAD_READY
+} LoadState;
+
+// A page being read, and the memory it is read into
+typedef struct {
+    int page;
+    LoadState state;
+    unsigned char* data;
+} PageLoad;
+
+// A page the feedback asked for, sorted coarsest level first
+typedef struct {
+    int level;
+    int page;
+} WantedPage;
+
+// Define the actual virtual texture implementation structure
+struct VirtualTextureImpl {
+    TileFile file;
+    const TileFileInfo* info;
+    int page_count;
+    size_t page_bytes;
+    
+    // The page cache holds one page per layer of a texture array
+    TextureArray cache;
+    int capacity;
+    int* slot_pages;       // Page in each slot, -1 if the slot is free
+    unsigned char* pinned; // Slots holding a coarsest level page
+    int* free_slots;
+    int free_count;
+    
+    // Cache slot + 1 of every page, 0 if not resident; read by the shaders
+    // as an integer buffer texture
+    unsigned int* table;
+    unsigned int table_buffer;
+    unsigned int table_texture;
+    bool table_dirty;
+    
+    // Number of the last feedback that needed each page, for eviction
+    unsigned int* page_used;
+    unsigned int feedback_number;
+    unsigned char* page_loading;
+    
+    // Pages of the latest feedback that are not resident yet
+    WantedPage* wanted;
+    int wanted_count;
+    int wanted_next;
+    
+    // Feedback target, and buffers the feedback is read back into
+    RenderTarget feedback_target;
+    unsigned int readback_buffers[VIRTUAL_TEXTURE_FEEDBACK_BUFFERS];
+    size_t readback_sizes[VIRTUAL_TEXTURE_FEEDBACK_BUFFERS];
+    int readback_texels[VIRTUAL_TEXTURE_FEEDBACK_BUFFERS];
+    GLsync readback_fences[VIRTUAL_TEXTURE_FEEDBACK_BUFFERS];
+    int readback_next;
+    bool synchronous;
+    
+    // Loader thread; the mutex guards the load states and the queue
+    PageLoad loads[VIRTUAL_TEXTURE_MAX_LOADS];
+    int queue[VIRTUAL_TEXTURE_MAX_LOADS];
+    int queue_head;
+    int queue_count;
+    pthread_t loader;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool loader_started;
+    bool quit;
+};
+
+// Read queued pages from the mapped file until told to quit
+static void* loader_main(void* arg) {
+    VirtualTexture texture = (VirtualTexture)arg;
+    
+    pthread_mutex_lock(&texture->mutex);
+    for (;;) {
+        while (!texture->quit && texture->queue_count == 0) {
+            pthread_cond_wait(&texture->cond, &texture->mutex);
+        }
+        if (texture->quit) break;
+        
+        int index = texture->queue[texture->queue_head];
+        texture->queue_head = (texture->queue_head + 1) % VIRTUAL_TEXTURE_MAX_LOADS;
+        texture->queue_count--;
+        PageLoad* load = &texture->loads[index];
+        load->state = LOAD_READING;
+        pthread_mutex_unlock(&texture->mutex);
+        
+        // Page faults on the mapping happen here, off the render thread
+        tile_file_read_page(texture->file, load->page, load->data);
+        
+        pthread_mutex_lock(&texture->mutex);
+        load->state = LOAD_READY;
+        pthread_cond_broadcast(&texture->cond);
+    }
+    pthread_mutex_unlock(&texture->mutex);
+    
+    return NULL;
+}
+
+// Page one level coarser covering the same area, or -1 at the coarsest level
+static int parent_page(VirtualTexture texture, int page) {
+    int layer, level, x, y;
+    tile_file_get_page_location(texture->info, page, &layer, &level, &x, &y);
+    if (level >= texture->info->level_count - 1) return -1;
+    return tile_file_get_page_number(texture->info, layer, level + 1, x / 2, y / 2);
+}
+
+// Sort wanted pages coarsest first, so fallbacks improve step by step
+static int compare_wanted(const void* a, const void* b) {
+    const WantedPage* x = (const WantedPage*)a;
+    const WantedPage* y = (const WantedPage*)b;
+    if (x->level != y->level) return y->level - x->level;
+    return (x->page > y->page) - (x->page < y->page);
+}
+
+// Collect the pages named by a finished feedback, with their coarser levels
+static void process_feedback(VirtualTexture texture, const unsigned int* texels, int count) {
+    texture->feedback_number++;
+    texture->wanted_count = 0;
+    texture->wanted_next = 0;
+    
+    for (int i = 0; i < count; i++) {
+        if (texels[i] == 0 || texels[i] > (unsigned int)texture->page_count) continue;
+        
+        // Stop at the first page this feedback already marked; its parents are too
+        int page = (int)texels[i] - 1;
+        while (page >= 0 && texture->page_used[page] != texture->feedback_number) {
+            texture->page_used[page] = texture->feedback_number;
+            if (!texture->table[page] && !texture->page_loading[page]) {
+                int layer, level, x, y;
+                tile_file_get_page_location(texture->info, page, &layer, &level, &x, &y);
+                texture->wanted[texture->wanted_count].level = level;
+                texture->wanted[texture->wanted_count].page = page;
+                texture->wanted_count++;
+            }
+            page = parent_page(texture, page);
+        }
+    }
+    
+    qsort(texture->wanted, (size_t)texture->wanted_count, sizeof(WantedPage), compare_wanted);
+}
+
+// Use the oldest feedback readbacks that have finished
+static void read_feedback(VirtualTexture texture) {
+    for (int k = 0; k < VIRTUAL_TEXTURE_FEEDBACK_BUFFERS; k++) {
+        int index = (texture->readback_next + k) % VIRTUAL_TEXTURE_FEEDBACK_BUFFERS;
+        GLsync fence = texture->readback_fences[index];
+        if (!fence) continue;
+        
+        GLuint64 timeout = texture->synchronous ? VIRTUAL_TEXTURE_FEEDBACK_TIMEOUT : 0;
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(fence);
+        texture->readback_fences[index] = NULL;
+        
+        int texel_count = texture->readback_texels[index];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, texture->readback_buffers[index]);
+        const unsigned int* texels = (const unsigned int*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+            (GLsizeiptr)texel_count * sizeof(unsigned int), GL_MAP_READ_BIT);
+        if (texels) {
+            process_feedback(texture, texels, texel_count);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+// Hand wanted pages to the loader while it has room
+static void queue_loads(VirtualTexture texture) {
+    pthread_mutex_lock(&texture->mutex);
+    for (int i = 0; i < VIRTUAL_TEXTURE_MAX_LOADS && texture->wanted_next < texture->wanted_count; i++) {
+        PageLoad* load = &texture->loads[i];
+        if (load->state != LOAD_FREE) continue;
+        
+        // Skip pages that arrived or were requested since the feedback was read
+        int page = -1;
+        while (texture->wanted_next < texture->wanted_count && page < 0) {
+            int candidate = texture->wanted[texture->wanted_next++].page;
+            if (!texture->table[candidate] && !texture->page_loading[candidate]) {
+                page = candidate;
+            }
+        }
+        if (page < 0) break;
+        
+        load->page = page;
+        load->state = LOAD_QUEUED;
+        texture->page_loading[page] = 1;
+        texture->queue[(texture->queue_head + texture->queue_count) % VIRTUAL_TEXTURE_MAX_LOADS] = i;
+        texture->queue_count++;
+    }
+    pthread_cond_broadcast(&texture->cond);
+    pthread_mutex_unlock(&texture->mutex);
+}
+
+// Block until the loader has read everything it was given
+static void wait_for_loads(VirtualTexture texture) {
+    pthread_mutex_lock(&texture->mutex);
+    for (;;) {
+        bool busy = false;
+        for (int i = 0; i < VIRTUAL_TEXTURE_MAX_LOADS; i++) {
+            if (texture->loads[i].state == LOAD_QUEUED || texture->loads[i].state == LOAD_READING) {
+                busy = true;
+            }
+        }
+        if (!busy) break;
+        pthread_cond_wait(&texture->cond, &texture->mutex);
+    }
+    pthread_mutex_unlock(&texture->mutex);
+}
+
+// Pick a slot for a new page: a free one, or the least recently needed page
+// that the latest feedback did not ask for. Returns -1 if every slot is needed.
+static int find_slot(VirtualTexture texture) {
+    if (texture->free_count > 0) {
+        return texture->free_slots[--texture->free_count];
+    }
+    
+    int victim = -1;
+    unsigned int oldest = texture->feedback_number;
+    for (int slot = 0; slot < texture->capacity; slot++) {
+        if (texture->pinned[slot]) continue;
+        unsigned int used = texture->page_used[texture->slot_pages[slot]];
+        if (used < oldest) {
+            oldest = used;
+            victim = slot;
+        }
+    }
+    if (victim >= 0) {
+        texture->table[texture->slot_pages[victim]] = 0;
+        texture->slot_pages[victim] = -1;
+    }
+    return victim;
+}
+
+// Put a page's data into the cache
+static bool place_page(VirtualTexture texture, int page, const void* data) {
+    int slot = find_slot(texture);
+    if (slot < 0) return false;
+    
+    int size = texture->info->page_size;
+    texture_array_upload(texture->cache, 0, slot, 0, 0, size, size, data);
+    texture->slot_pages[slot] = page;
+    texture->table[page] = (unsigned int)slot + 1;
+    texture->table_dirty = true;
+    return true;
+}
+
+// Upload pages the loader has finished, up to limit of them
+static void upload_loads(VirtualTexture texture, int limit) {
+    int uploaded = 0;
+    for (int i = 0; i < VIRTUAL_TEXTURE_MAX_LOADS && uploaded < limit; i++) {
+        PageLoad* load = &texture->loads[i];
+        pthread_mutex_lock(&texture->mutex);
+        bool ready = load->state == LOAD_READY;
+        pthread_mutex_unlock(&texture->mutex);
+        if (!ready) continue;
+        
+        // Without a free slot the page is dropped; later feedback asks again
+        place_page(texture, load->page, load->data);
+        texture->page_loading[load->page] = 0;
+        uploaded++;
+        
+        pthread_mutex_lock(&texture->mutex);
+        load->state = LOAD_FREE;
+        pthread_mutex_unlock(&texture->mutex);
+    }
+}
+
+VirtualTexture virtual_texture_create(const char* path, size_t budget) {
+    VirtualTexture texture = (VirtualTexture)calloc(1, sizeof(struct VirtualTextureImpl));
+    if (!texture) {
+        fprintf(stderr, "Failed to allocate virtual texture\n");
+        return NULL;
+    }
+    pthread_mutex_init(&texture->mutex, NULL);
+    pthread_cond_init(&texture->cond, NULL);
+    
+    texture->file = tile_file_open(path);
+    if (!texture->file) {
+        virtual_texture_destroy(texture);
+        return NULL;
+    }
+    texture->info = tile_file_get_info(texture->file);
+    texture->page_count = tile_file_get_page_count(texture->file);
+    texture->page_bytes = tile_file_get_page_bytes(texture->file);
+    
+    // As many slots as the budget pays for, within the array layer limit
+    int max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    size_t capacity = budget / texture->page_bytes;
+    if (max_layers > 0 && capacity > (size_t)max_layers) {
+        capacity = (size_t)max_layers;
+    }
+    if (capacity > (size_t)texture->page_count) {
+        capacity = (size_t)texture->page_count;
+    }
+    texture->capacity = (int)capacity;
+    if (texture->capacity <= texture->info->layer_count && texture->capacity < texture->page_count) {
+        fprintf(stderr, "Texture budget of %zu bytes cannot hold more than the %d coarsest pages\n",
+                budget, texture->info->layer_count);
+        virtual_texture_destroy(texture);
+        return NULL;
+    }
+    
+    texture->cache = texture_array_create(texture->info->format, texture->info->page_size, texture->info->page_size,
+                                          texture->capacity, 1);
+    texture->slot_pages = (int*)malloc((size_t)texture->capacity * sizeof(int));
+    texture->pinned = (unsigned char*)calloc((size_t)texture->capacity, 1);
+    texture->free_slots = (int*)malloc((size_t)texture->capacity * sizeof(int));
+    texture->table = (unsigned int*)calloc((size_t)texture->page_count, sizeof(unsigned int));
+    texture->page_used = (unsigned int*)calloc((size_t)texture->page_count, sizeof(unsigned int));
+    texture->page_loading = (unsigned char*)calloc((size_t)texture->page_count, 1);
+    texture->wanted = (WantedPage*)malloc((size_t)texture->page_count * sizeof(WantedPage));
+    bool ok = texture->cache && texture->slot_pages && texture->pinned && texture->free_slots &&
+              texture->table && texture->page_used && texture->page_loading && texture->wanted;
+    for (int i = 0; ok && i < VIRTUAL_TEXTURE_MAX_LOADS; i++) {
+        texture->loads[i].data = (unsigned char*)malloc(texture->page_bytes);
+        ok = texture->loads[i].data != NULL;
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to create virtual texture\n");
+        virtual_texture_destroy(texture);
+        return NULL;
+    }
+    
+    // Slots are handed out from the end of the free list
+    for (int slot = 0; slot < texture->capacity; slot++) {
+        texture->slot_pages[slot] = -1;
+        texture->free_slots[slot] = texture->capacity - 1 - slot;
+    }
+    texture->free_count = texture->capacity;
+    
+    // The coarsest page of every layer stays resident for good
+    int top = texture->info->level_count - 1;
+    for (int layer = 0; layer < texture->info->layer_count; layer++) {
+        int page = tile_file_get_page_number(texture->info, layer, top, 0, 0);
+        tile_file_read_page(texture->file, page, texture->loads[0].data);
+        place_page(texture, page, texture->loads[0].data);
+        texture->pinned[texture->table[page] - 1] = 1;
+    }
+    
+    glGenBuffers(1, &texture->table_buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, texture->table_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)texture->page_count * sizeof(unsigned int), texture->table, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glGenTextures(1, &texture->table_texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture->table_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, texture->table_buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    texture->table_dirty = false;
+    
+    glGenBuffers(VIRTUAL_TEXTURE_FEEDBACK_BUFFERS, texture->readback_buffers);
+    
+    if (pthread_create(&texture->loader, NULL, loader_main, texture) != 0) {
+        fprintf(stderr, "Failed to start texture loader thread\n");
+        virtual_texture_destroy(texture);
+        return NULL;
+    }
+    texture->loader_started = true;
+    
+    printf("Virtual texture: %d %s layers of %d pages, %d page cache slots (%zu KB)\n",
+           texture->info->layer_count, texture_format_get_name(texture->info->format),
+           texture->page_count / texture->info->layer_count, texture->capacity,
+           (size_t)texture->capacity * texture->page_bytes / 1024);
+    return texture;
+}
+
+const TileFileInfo* virtual_texture_get_info(VirtualTexture texture) {
+    return texture ? texture->info : NULL;
+}
+
+void virtual_texture_set_synchronous(VirtualTexture texture, bool synchronous) {
+    if (!texture) return;
+    
+    texture->synchronous = synchronous;
+}
+
+void virtual_texture_begin_feedback(VirtualTexture texture, int width, int height) {
+    if (!texture) return;
+    
+    // Page numbers are written as unsigned integers, 0 meaning no page
+    if (!texture->feedback_target) {
+        RenderTargetConfig config = render_target_config_default();
+        config.width = width;
+        config.height = height;
+        config.color = RENDER_TARGET_COLOR_R32UI;
+        texture->feedback_target = render_target_create(config);
+        if (!texture->feedback_target) return;
+    } else if (!render_target_resize(texture->feedback_target, width, height)) {
+        return;
+    }
+    render_target_bind(texture->feedback_target, 0);
+    
+    const unsigned int no_page[4] = { 0, 0, 0, 0 };
+    const float far_depth = 1.0f;
+    glClearBufferuiv(GL_COLOR, 0, no_page);
+    glClearBufferfv(GL_DEPTH, 0, &far_depth);
+}
+
+void virtual_texture_end_feedback(VirtualTexture texture) {
+    if (!texture || !texture->feedback_target) return;
+    
+    // Reuse the oldest buffer, dropping its result if it was never read
+    int index = texture->readback_next;
+    texture->readback_next = (index + 1) % VIRTUAL_TEXTURE_FEEDBACK_BUFFERS;
+    if (texture->readback_fences[index]) {
+        glDeleteSync(texture->readback_fences[index]);
+    }
+    
+    int width, height;
+    render_target_get_size(texture->feedback_target, &width, &height);
+    int texel_count = width * height;
+    size_t size = (size_t)texel_count * sizeof(unsigned int);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, texture->readback_buffers[index]);
+    if (size > texture->readback_sizes[index]) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_READ);
+        texture->readback_sizes[index] = size;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    texture->readback_fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    texture->readback_texels[index] = texel_count;
+    
+    render_target_unbind();
+}
+
+void virtual_texture_update(VirtualTexture texture) {
+    if (!texture) return;
+    
+    read_feedback(texture);
+    
+    if (texture->synchronous) {
+        // Work through everything the feedback asked for before returning
+        do {
+            queue_loads(texture);
+            wait_for_loads(texture);
+            upload_loads(texture, VIRTUAL_TEXTURE_MAX_LOADS);
+        } while (texture->wanted_next < texture->wanted_count);
+    } else {
+        upload_loads(texture, VIRTUAL_TEXTURE_UPLOADS_PER_FRAME);
+        queue_loads(texture);
+    }
+    
+    if (texture->table_dirty) {
+        glBindBuffer(GL_TEXTURE_BUFFER, texture->table_buffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)texture->page_count * sizeof(unsigned int), texture->table);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        texture->table_dirty = false;
+    }
+}
+
+void virtual_texture_bind(VirtualTexture texture, ShaderProgram program, int cache_unit, int table_unit) {
+    if (!texture) return;
+    
+    glActiveTexture(GL_TEXTURE0 + (unsigned int)cache_unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_array_get_texture(texture->cache));
+    glActiveTexture(GL_TEXTURE0 + (unsigned int)table_unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture->table_texture);
+    glActiveTexture(GL_TEXTURE0);
+    
+    shader_set_int(program, "pageCache", cache_unit);
+    shader_set_int(program, "pageTable", table_unit);
+    shader_set_int(program, "virtualLayers", texture->info->layer_count);
+    shader_set_int(program, "virtualPages", texture->info->pages);
+    shader_set_int(program, "virtualLevels", texture->info->level_count);
+    shader_set_int(program, "pageSize", texture->info->page_size);
+    shader_set_int(program, "pageBorder", texture->info->border);
+}
+
+void virtual_texture_get_residency(VirtualTexture texture, int* resident, int* capacity) {
+    if (!texture) return;
+    
+    *resident = texture->capacity - texture->free_count;
+    *capacity = texture->capacity;
+}
+
+size_t virtual_texture_get_memory_size(VirtualTexture texture) {
+    if (!texture) return 0;
+    
+    size_t size = (size_t)texture->capacity * texture->page_bytes + (size_t)texture->page_count * sizeof(unsigned int) +
+                  render_target_get_memory_size(texture->feedback_target);
+    for (int i = 0; i < VIRTUAL_TEXTURE_FEEDBACK_BUFFERS; i++) {
+        size += texture->readback_sizes[i];
+    }
+    return size;
+}
+
+void virtual_texture_destroy(VirtualTexture texture) {
+    if (!texture) return;
+    
+    // Stop the loader before freeing what it reads into
+    if (texture->loader_started) {
+        pthread_mutex_lock(&texture->mutex);
+        texture->quit = true;
+        pthread_cond_broadcast(&texture->cond);
+        pthread_mutex_unlock(&texture->mutex);
+        pthread_join(texture->loader, NULL);
+    }
+    
+    for (int i = 0; i < VIRTUAL_TEXTURE_FEEDBACK_BUFFERS; i++) {
+        if (texture->readback_fences[i]) {
+            glDeleteSync(texture->readback_fences[i]);
+        }
+    }
+    if (texture->readback_buffers[0]) {
+        glDeleteBuffers(VIRTUAL_TEXTURE_FEEDBACK_BUFFERS, texture->readback_buffers);
+    }
+    render_target_destroy(texture->feedback_target);
+    if (texture->table_texture) {
+        glDeleteTextures(1, &texture->table_texture);
+        glDeleteBuffers(1, &texture->table_buffer);
+    }
+    texture_array_destroy(texture->cache);
+    
+    for (int i = 0; i < VIRTUAL_TEXTURE_MAX_LOADS; i++) {
+        free(texture->loads[i].data);
+    }
+    free(texture->slot_pages);
+    free(texture->pinned);
+    free(texture->free_slots);
+    free(texture->table);
+    free(texture->page_used);
+    free(texture->page_loading);
+    free(texture->wanted);
+    tile_file_close(texture->file);
+    
+    pthread_mutex_destroy(&texture->mutex);
+    pthread_cond_destroy(&texture->cond);
+    free(texture);
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "tile_file.h"
+#include "../shader/shader.h"
+
+// Opaque handle for a virtual texture
+// The layers of a tile file, of which only the pages recently asked for by
+// a feedback pass are kept in a fixed-size page cache on the GPU. A page
+// table maps every page to its cache slot; pages that are not resident fall
+// back to the nearest coarser one, and the coarsest level of every layer is
+// always resident. Pages are read from the mapped file on a background thread.
+typedef struct VirtualTextureImpl* VirtualTexture;
+
+// Open a tile file with a page cache of at most budget bytes of GPU memory
+// Needs a current GL context and loads the coarsest level of every layer
+// before returning. Returns NULL if the file cannot be used.
+VirtualTexture virtual_texture_create(const char* path, size_t budget);
+
+// Get the layout of the underlying tile file
+const TileFileInfo* virtual_texture_get_info(VirtualTexture texture);
+
+// Make every update wait for the pages its feedback asks for, so the output
+// no longer depends on disk and thread timing (for replays)
+void virtual_texture_set_synchronous(VirtualTexture texture, bool synchronous);
+
+// Bind (and resize) the width x height feedback target and clear it
+// Draw the scene with a shader writing page numbers + 1, then end the pass.
+// Feedback must always be drawn from the same GL context.
+void virtual_texture_begin_feedback(VirtualTexture texture, int width, int height);
+
+// Start reading the feedback back and restore the default framebuffer
+void virtual_texture_end_feedback(VirtualTexture texture);
+
+// Request the pages of the newest finished feedback and upload pages the
+// loader has read, evicting the least recently needed; call once per frame
+void virtual_texture_update(VirtualTexture texture);
+
+// Bind the page cache and page table to two texture units and set the
+// shader's virtual texture uniforms
+void virtual_texture_bind(VirtualTexture texture, ShaderProgram program, int cache_unit, int table_unit);
+
+// Get the number of resident pages and the capacity of the page cache
+void virtual_texture_get_residency(VirtualTexture texture, int* resident, int* capacity);
+
+// Get the GPU memory taken by the page cache, page table and feedback, in bytes
+size_t virtual_texture_get_memory_size(VirtualTexture texture);
+
+// Stop the loader and release the file and GL objects
+void virtual_texture_destroy(VirtualTexture texture);
+
+#endif /* VIRTUAL_TEXTURE_H */
\ No newline at end of file
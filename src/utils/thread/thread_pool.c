@@ -0,0 +1,162 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Upper bound on worker threads, whatever the core count
+#define THREAD_POOL_MAX_THREADS 32
+
+// Define the actual thread pool implementation structure
+struct ThreadPoolImpl {
+    pthread_t* threads;
+    int thread_count;
+    
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    unsigned int generation;
+    bool shutting_down;
+    
+    // Job currently being executed
+    ThreadPoolTask task;
+    void* context;
+    int count;
+    int batch_size;
+    atomic_int next_index;
+    int active_workers;
+};
+
+// Claim batches of the current job until none are left
+static void run_batches(ThreadPool pool) {
+    for (;;) {
+        int begin = atomic_fetch_add(&pool->next_index, pool->batch_size);
+        if (begin >= pool->count) break;
+        
+        int end = begin + pool->batch_size;
+        if (end > pool->count) end = pool->count;
+        pool->task(pool->context, begin, end);
+    }
+}
+
+static void* worker_thread(void* arg) {
+    ThreadPool pool = (ThreadPool)arg;
+    unsigned int seen_generation = 0;
+    
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutting_down && pool->generation == seen_generation) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutting_down) break;
+        seen_generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        
+        run_batches(pool);
+        
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active_workers == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    
+    return NULL;
+}
+
+ThreadPool thread_pool_create(int thread_count) {
+    if (thread_count <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cores > 1 ? (int)cores - 1 : 0;
+    }
+    if (thread_count > THREAD_POOL_MAX_THREADS) {
+        thread_count = THREAD_POOL_MAX_THREADS;
+    }
+    
+    ThreadPool pool = (ThreadPool)calloc(1, sizeof(struct ThreadPoolImpl));
+    if (!pool) {
+        fprintf(stderr, "Failed to allocate thread pool\n");
+        return NULL;
+    }
+    
+    pool->threads = (pthread_t*)calloc(thread_count > 0 ? (size_t)thread_count : 1, sizeof(pthread_t));
+    if (!pool->threads) {
+        fprintf(stderr, "Failed to allocate thread pool\n");
+        free(pool);
+        return NULL;
+    }
+    
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    
+    // Start the workers; if some fail to start, run with the ones we have
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_thread, pool) != 0) {
+            fprintf(stderr, "Failed to start worker thread %d\n", i);
+            break;
+        }
+        pool->thread_count++;
+    }
+    
+    return pool;
+}
+
+void thread_pool_parallel_for(ThreadPool pool, int count, int batch_size, ThreadPoolTask task, void* context) {
+    if (count <= 0) return;
+    if (batch_size < 1) batch_size = 1;
+    
+    // Not worth waking anyone up
+    if (!pool || pool->thread_count == 0 || count <= batch_size) {
+        task(context, 0, count);
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    pool->batch_size = batch_size;
+    atomic_store(&pool->next_index, 0);
+    pool->active_workers = pool->thread_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    
+    // Help out instead of just waiting
+    run_batches(pool);
+    
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active_workers > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int thread_pool_get_thread_count(ThreadPool pool) {
+    if (!pool) return 1;
+    return pool->thread_count + 1;
+}
+
+void thread_pool_destroy(ThreadPool pool) {
+    if (!pool) return;
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->shutting_down = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
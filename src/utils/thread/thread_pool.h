@@ -0,0 +1,26 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Opaque handle for a pool of worker threads
+typedef struct ThreadPoolImpl* ThreadPool;
+
+// Task run over the index range [begin, end)
+typedef void (*ThreadPoolTask)(void* context, int begin, int end);
+
+// Create a thread pool
+// A thread_count of 0 picks one worker per available core, minus the caller
+ThreadPool thread_pool_create(int thread_count);
+
+// Run task over [0, count) split into batches of at least batch_size indices
+// The calling thread takes part and the call returns once every batch is done.
+// Small ranges (count <= batch_size) or a NULL pool run inline on the caller.
+// Only one thread may issue work at a time, and tasks must not call back in.
+void thread_pool_parallel_for(ThreadPool pool, int count, int batch_size, ThreadPoolTask task, void* context);
+
+// Number of threads that run tasks, including the caller
+int thread_pool_get_thread_count(ThreadPool pool);
+
+// Stop the workers and free the pool
+void thread_pool_destroy(ThreadPool pool);
+
+#endif /* THREAD_POOL_H */
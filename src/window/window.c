@@ -6,6 +6,8 @@
 // Define the actual window implementation structure
 struct WindowImpl {
     GLFWwindow* glfw_window;
+    WindowKeyHandler key_handler;
+    void* key_handler_data;
 };
 
 // Error callback for GLFW
@@ -18,6 +20,12 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
+    
+    // Forward the event to whoever registered for it
+    Window handle = (Window)glfwGetWindowUserPointer(window);
+    if (handle && handle->key_handler) {
+        handle->key_handler(handle->key_handler_data, key, action, mods);
+    }
 }
 
 // Framebuffer size callback
@@ -36,16 +44,8 @@ WindowConfig window_config_default(void) {
     return config;
 }
 
-Window window_init(WindowConfig config) {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        fprintf(stderr, "Failed to initialize window system\n");
-        return NULL;
-    }
-    
-    // Set error callback
-    glfwSetErrorCallback(error_callback);
-    
+// Create a GLFW window (sharing objects with share, if given) and wrap it in a handle
+static Window create_window(WindowConfig config, GLFWwindow* share) {
     // Set OpenGL version hints
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, config.gl_major_version);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, config.gl_minor_version);
@@ -60,14 +60,13 @@ Window window_init(WindowConfig config) {
     if (config.fullscreen) {
         GLFWmonitor* monitor = glfwGetPrimaryMonitor();
         const GLFWvidmode* mode = glfwGetVideoMode(monitor);
-        glfw_window = glfwCreateWindow(mode->width, mode->height, config.title, monitor, NULL);
+        glfw_window = glfwCreateWindow(mode->width, mode->height, config.title, monitor, share);
     } else {
-        glfw_window = glfwCreateWindow(config.width, config.height, config.title, NULL, NULL);
+        glfw_window = glfwCreateWindow(config.width, config.height, config.title, NULL, share);
     }
     
     if (!glfw_window) {
         fprintf(stderr, "Failed to create window\n");
-        glfwTerminate();
         return NULL;
     }
     
@@ -77,8 +76,9 @@ Window window_init(WindowConfig config) {
     // Set framebuffer size callback
     glfwSetFramebufferSizeCallback(glfw_window, framebuffer_size_callback);
     
-    // Enable vsync (swap interval 1)
-    glfwSwapInterval(1);
+    // Enable vsync (swap interval 1) on the main window only; with several
+    // windows, each extra vsync wait would divide the frame rate
+    glfwSwapInterval(share ? 0 : 1);
     
     // Initialize viewport
     glViewport(0, 0, config.width, config.height);
@@ -88,14 +88,96 @@ Window window_init(WindowConfig config) {
     if (!handle) {
         fprintf(stderr, "Failed to allocate window handle\n");
         glfwDestroyWindow(glfw_window);
+        return NULL;
+    }
+    
+    handle->glfw_window = glfw_window;
+    handle->key_handler = NULL;
+    handle->key_handler_data = NULL;
+    glfwSetWindowUserPointer(glfw_window, handle);
+    return handle;
+}
+
+Window window_init(WindowConfig config) {
+    // Initialize GLFW
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize window system\n");
+        return NULL;
+    }
+    
+    // Set error callback
+    glfwSetErrorCallback(error_callback);
+    
+    Window handle = create_window(config, NULL);
+    if (!handle) {
         glfwTerminate();
         return NULL;
     }
     
+    return handle;
+}
+
+Window window_create_shared(WindowConfig config, Window share) {
+    if (!share) return NULL;
+    
+    return create_window(config, share->glfw_window);
+}
+
+Window window_create_shared_context(Window share) {
+    if (!share) return NULL;
+    
+    // The shared context is never shown; it only exists to own a GL context
+    // whose objects (programs, buffers, textures) are visible to the main one
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* glfw_window = glfwCreateWindow(1, 1, "", NULL, share->glfw_window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    
+    if (!glfw_window) {
+        fprintf(stderr, "Failed to create shared context\n");
+        return NULL;
+    }
+    
+    Window handle = (Window)malloc(sizeof(struct WindowImpl));
+    if (!handle) {
+        fprintf(stderr, "Failed to allocate window handle\n");
+        glfwDestroyWindow(glfw_window);
+        return NULL;
+    }
+    
     handle->glfw_window = glfw_window;
+    handle->key_handler = NULL;
+    handle->key_handler_data = NULL;
+    glfwSetWindowUserPointer(glfw_window, handle);
     return handle;
 }
 
+void window_destroy_shared(Window window) {
+    if (!window) return;
+    
+    glfwDestroyWindow(window->glfw_window);
+    free(window);
+}
+
+void window_make_context_current(Window window) {
+    glfwMakeContextCurrent(window ? window->glfw_window : NULL);
+}
+
+int window_get_refresh_rate(void) {
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : NULL;
+    return mode ? mode->refreshRate : 0;
+}
+
+void window_get_framebuffer_size(Window window, int* width, int* height) {
+    if (!window) {
+        *width = 0;
+        *height = 0;
+        return;
+    }
+    
+    glfwGetFramebufferSize(window->glfw_window, width, height);
+}
+
 void window_setup_callbacks(Window window) {
     if (!window) return;
     
@@ -103,6 +185,23 @@ void window_setup_callbacks(Window window) {
     glfwSetKeyCallback(window->glfw_window, key_callback);
 }
 
+void window_set_key_handler(Window window, WindowKeyHandler handler, void* user_data) {
+    if (!window) return;
+    
+    window->key_handler = handler;
+    window->key_handler_data = user_data;
+}
+
+void window_set_swap_interval(Window window, int interval) {
+    if (!window) return;
+    
+    // The swap interval belongs to the current context
+    GLFWwindow* previous = glfwGetCurrentContext();
+    glfwMakeContextCurrent(window->glfw_window);
+    glfwSwapInterval(interval);
+    glfwMakeContextCurrent(previous);
+}
+
 void window_terminate(Window window) {
     if (!window) return;
     
@@ -10,6 +10,9 @@ typedef struct GLFWwindow GLFWwindow;
 // This hides the implementation detail that we're using GLFW
 typedef struct WindowImpl* Window;
 
+// Callback for key events (GLFW key codes, actions and modifier bits)
+typedef void (*WindowKeyHandler)(void* user_data, int key, int action, int mods);
+
 // Window configuration structure
 typedef struct {
     int width;
@@ -26,9 +29,35 @@ WindowConfig window_config_default(void);
 // Initialize and create a window
 Window window_init(WindowConfig config);
 
+// Create an additional window whose GL context shares objects with the given window
+// Buffers, textures and programs are shared; vertex arrays are not
+Window window_create_shared(WindowConfig config, Window share);
+
+// Create a hidden window whose GL context shares objects with the given window
+// Meant for background work such as shader compilation on another thread
+Window window_create_shared_context(Window share);
+
+// Destroy a window created with window_create_shared or window_create_shared_context
+void window_destroy_shared(Window window);
+
+// Make the window's GL context current on the calling thread (NULL detaches)
+void window_make_context_current(Window window);
+
+// Get the size of the window's framebuffer in pixels
+void window_get_framebuffer_size(Window window, int* width, int* height);
+
+// Get the refresh rate of the primary monitor in Hz (0 if unknown)
+int window_get_refresh_rate(void);
+
 // Set up callbacks for the window
 void window_setup_callbacks(Window window);
 
+// Receive the window's key events (after its own ESC handling)
+void window_set_key_handler(Window window, WindowKeyHandler handler, void* user_data);
+
+// Set the number of vertical blanks to wait for on swap (0 disables vsync)
+void window_set_swap_interval(Window window, int interval);
+
 // Clean up and terminate window system
 void window_terminate(Window window);
 